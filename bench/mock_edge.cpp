@@ -0,0 +1,739 @@
+// Local stand-in for Cloudflare edges.
+//
+// Accepts connections for every address in a loopback range (Linux routes all
+// of 127.0.0.0/8 to lo, so a single wildcard listener sees them all) and
+// answers HEAD/GET requests with CF-Cache-Status, CF-Ray and CF-IPCountry
+// headers. Whether an edge has the object cached, its colo and whether it is
+// a blackhole are derived from a hash of its address, so repeated runs see
+// the same "network". Latency, drops and resets are drawn per request.
+//
+//   cfpinner_mock_edge --range 127.0.0.0/20 --hit-ratio 0.1
+//       --latency lognormal:20:0.5 --drop 0.01 --reset 0.01 --blackhole 0.05
+//
+// Runs until SIGINT/SIGTERM and then prints request counters.
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <queue>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#ifdef CFPINNER_MOCK_TLS
+#include <openssl/err.h>
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+#include <openssl/ssl.h>
+#include <openssl/x509.h>
+#endif
+
+namespace {
+
+struct Options {
+    std::string bind_address = "0.0.0.0";
+    uint16_t tls_port = 8443;     // 0 disables HTTPS
+    uint16_t http_port = 8080;    // 0 disables plain HTTP
+    uint32_t range_base = 0x7f000000; // 127.0.0.0/16
+    uint32_t range_mask = 0xffff0000;
+    size_t workers = 1;
+    double hit_ratio = 0.1;       // Share of edges that have the object cached
+    double blackhole = 0.0;       // Share of edges that accept but never answer
+    double drop = 0.0;            // Per request: close without answering
+    double reset = 0.0;           // Per request: abort the connection with RST
+    std::string latency = "0";    // Response delay distribution (milliseconds)
+    uint64_t seed = 1;
+    std::string cert_file;
+    std::string key_file;
+};
+
+// Response delay distribution, parsed from "0", "fixed:MS", "uniform:MIN:MAX"
+// or "lognormal:MEDIAN:SIGMA"
+struct Latency {
+    enum Kind { NONE, FIXED, UNIFORM, LOGNORMAL } kind = NONE;
+    double a = 0;
+    double b = 0;
+
+    bool parse(const std::string& spec) {
+        double x = 0, y = 0;
+        if (spec == "0" || spec == "none") {
+            kind = NONE;
+        } else if (std::sscanf(spec.c_str(), "fixed:%lf", &x) == 1) {
+            kind = FIXED;
+            a = x;
+        } else if (std::sscanf(spec.c_str(), "uniform:%lf:%lf", &x, &y) == 2 && y >= x) {
+            kind = UNIFORM;
+            a = x;
+            b = y;
+        } else if (std::sscanf(spec.c_str(), "lognormal:%lf:%lf", &x, &y) == 2 && x > 0) {
+            kind = LOGNORMAL;
+            a = x;
+            b = y;
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+    long sampleMs(std::mt19937_64& rng) const {
+        switch (kind) {
+            case FIXED:
+                return static_cast<long>(a);
+            case UNIFORM:
+                return static_cast<long>(std::uniform_real_distribution<double>(a, b)(rng));
+            case LOGNORMAL:
+                return static_cast<long>(std::lognormal_distribution<double>(std::log(a), b)(rng));
+            default:
+                return 0;
+        }
+    }
+};
+
+struct Counters {
+    std::atomic<uint64_t> connections{0};
+    std::atomic<uint64_t> requests{0};
+    std::atomic<uint64_t> hits{0};
+    std::atomic<uint64_t> drops{0};
+    std::atomic<uint64_t> resets{0};
+    std::atomic<uint64_t> blackholed{0};
+    std::atomic<uint64_t> out_of_range{0};
+};
+
+Options g_options;
+Latency g_latency;
+Counters g_counters;
+std::atomic<bool> g_stop{false};
+
+#ifdef CFPINNER_MOCK_TLS
+SSL_CTX* g_ssl_ctx = nullptr;
+#endif
+
+const char* const kColos[] = {"SJC", "LAX", "SEA", "ORD", "IAD", "EWR", "MIA", "DFW",
+                              "AMS", "FRA", "LHR", "CDG", "NRT", "SIN", "HKG", "SYD"};
+const char* const kCountries[] = {"US", "US", "US", "US", "US", "US", "US", "US",
+                                  "NL", "DE", "GB", "FR", "JP", "SG", "HK", "AU"};
+
+uint64_t mix(uint64_t x) {
+    // splitmix64 finalizer
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+// Stable per-edge value in [0, 1) for the given purpose
+double edgeUniform(uint32_t ip, uint64_t purpose) {
+    return (mix(g_options.seed ^ (static_cast<uint64_t>(ip) << 8) ^ purpose) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+long long nowMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void closeAbortive(int fd) {
+    struct linger lg;
+    lg.l_onoff = 1;
+    lg.l_linger = 0;
+    setsockopt(fd, SOL_SOCKET, SO_LINGER, &lg, sizeof(lg));
+    close(fd);
+}
+
+struct Connection {
+    enum State { HANDSHAKE, READING, DELAYED, WRITING, HOLD };
+
+    int fd = -1;
+    uint32_t generation = 0;   // Bumped on reuse so stale timers are skipped
+    uint32_t local_ip = 0;     // Edge address the client dialed
+    State state = READING;
+    std::string in;
+    std::string out;
+    size_t out_pos = 0;
+    bool want_write = false;   // EPOLLOUT is registered
+#ifdef CFPINNER_MOCK_TLS
+    SSL* ssl = nullptr;
+#endif
+};
+
+class Worker {
+public:
+    explicit Worker(size_t index) : rng_(mix(g_options.seed + index)) {}
+
+    bool init() {
+        epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+        if (epoll_fd_ < 0) {
+            return false;
+        }
+        if (g_options.http_port && !listenOn(g_options.http_port, false)) {
+            return false;
+        }
+#ifdef CFPINNER_MOCK_TLS
+        if (g_options.tls_port && !listenOn(g_options.tls_port, true)) {
+            return false;
+        }
+#endif
+        return true;
+    }
+
+    void run() {
+        const int max_events = 256;
+        struct epoll_event events[max_events];
+
+        while (!g_stop.load()) {
+            int wait_ms = 200;
+            if (!timers_.empty()) {
+                long long remaining = timers_.top().due_ms - nowMs();
+                wait_ms = static_cast<int>(std::max(0LL, std::min(remaining, 200LL)));
+            }
+
+            int n = epoll_wait(epoll_fd_, events, max_events, wait_ms);
+            for (int i = 0; i < n; i++) {
+                uint64_t tag = events[i].data.u64;
+                if (tag & kListenTag) {
+                    acceptAll(static_cast<int>(tag & 0xffffffff), (tag & kTlsTag) != 0);
+                } else {
+                    handle(static_cast<int>(tag), events[i].events);
+                }
+            }
+
+            long long now = nowMs();
+            while (!timers_.empty() && timers_.top().due_ms <= now) {
+                Timer timer = timers_.top();
+                timers_.pop();
+                Connection* conn = lookup(timer.fd);
+                if (conn && conn->generation == timer.generation && conn->state == Connection::DELAYED) {
+                    startResponse(*conn);
+                }
+            }
+        }
+    }
+
+private:
+    static const uint64_t kListenTag = 1ULL << 62;
+    static const uint64_t kTlsTag = 1ULL << 61;
+
+    struct Timer {
+        long long due_ms;
+        int fd;
+        uint32_t generation;
+        bool operator<(const Timer& other) const { return due_ms > other.due_ms; }
+    };
+
+    int epoll_fd_ = -1;
+    std::mt19937_64 rng_;
+    std::vector<Connection> conns_;   // Indexed by fd
+    std::priority_queue<Timer> timers_;
+    uint64_t ray_counter_ = 0;
+
+    bool listenOn(uint16_t port, bool tls) {
+        int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd < 0) {
+            return false;
+        }
+        int one = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one));
+
+        struct sockaddr_in addr;
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        if (inet_pton(AF_INET, g_options.bind_address.c_str(), &addr.sin_addr) != 1 ||
+            bind(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) != 0 ||
+            listen(fd, 4096) != 0) {
+            std::cerr << "Failed to listen on " << g_options.bind_address << ":" << port
+                      << ": " << std::strerror(errno) << std::endl;
+            close(fd);
+            return false;
+        }
+
+        struct epoll_event ev = {};
+        ev.events = EPOLLIN;
+        ev.data.u64 = kListenTag | (tls ? kTlsTag : 0) | static_cast<uint32_t>(fd);
+        epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev);
+        return true;
+    }
+
+    Connection* lookup(int fd) {
+        if (fd < 0 || static_cast<size_t>(fd) >= conns_.size() || conns_[fd].fd != fd) {
+            return nullptr;
+        }
+        return &conns_[fd];
+    }
+
+    void acceptAll(int listen_fd, bool tls) {
+        while (true) {
+            int fd = accept4(listen_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0) {
+                return;
+            }
+
+            struct sockaddr_in local;
+            socklen_t len = sizeof(local);
+            getsockname(fd, reinterpret_cast<struct sockaddr*>(&local), &len);
+            uint32_t local_ip = ntohl(local.sin_addr.s_addr);
+
+            // Addresses outside the simulated range behave like closed ports
+            if ((local_ip & g_options.range_mask) != g_options.range_base) {
+                g_counters.out_of_range++;
+                closeAbortive(fd);
+                continue;
+            }
+            g_counters.connections++;
+
+            int one = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+            if (static_cast<size_t>(fd) >= conns_.size()) {
+                conns_.resize(fd + 1024);
+            }
+            Connection& conn = conns_[fd];
+            conn.fd = fd;
+            conn.generation++;
+            conn.local_ip = local_ip;
+            conn.in.clear();
+            conn.out.clear();
+            conn.out_pos = 0;
+            conn.want_write = false;
+            conn.state = Connection::READING;
+
+            // Blackholed edges complete the handshake (the kernel does that)
+            // and then never say a word
+            if (edgeUniform(local_ip, 3) < g_options.blackhole) {
+                g_counters.blackholed++;
+                conn.state = Connection::HOLD;
+            }
+
+#ifdef CFPINNER_MOCK_TLS
+            if (tls && conn.state != Connection::HOLD) {
+                conn.ssl = SSL_new(g_ssl_ctx);
+                SSL_set_fd(conn.ssl, fd);
+                SSL_set_accept_state(conn.ssl);
+                conn.state = Connection::HANDSHAKE;
+            }
+#else
+            (void)tls;
+#endif
+
+            struct epoll_event ev = {};
+            ev.events = EPOLLIN | EPOLLRDHUP;
+            ev.data.u64 = static_cast<uint32_t>(fd);
+            epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev);
+        }
+    }
+
+    void closeConnection(Connection& conn, bool abortive) {
+        epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, conn.fd, nullptr);
+#ifdef CFPINNER_MOCK_TLS
+        if (conn.ssl) {
+            SSL_free(conn.ssl);
+            conn.ssl = nullptr;
+        }
+#endif
+        if (abortive) {
+            closeAbortive(conn.fd);
+        } else {
+            close(conn.fd);
+        }
+        conn.fd = -1;
+        conn.generation++;
+    }
+
+    void watch(Connection& conn, bool writable) {
+        conn.want_write = writable;
+        struct epoll_event ev = {};
+        ev.events = EPOLLIN | EPOLLRDHUP | (writable ? static_cast<uint32_t>(EPOLLOUT) : 0u);
+        ev.data.u64 = static_cast<uint32_t>(conn.fd);
+        epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, conn.fd, &ev);
+    }
+
+    // Read whatever is available; returns false when the peer is gone
+    bool readAvailable(Connection& conn) {
+        char buffer[4096];
+        while (true) {
+            ssize_t n;
+#ifdef CFPINNER_MOCK_TLS
+            if (conn.ssl) {
+                int r = SSL_read(conn.ssl, buffer, sizeof(buffer));
+                if (r <= 0) {
+                    int err = SSL_get_error(conn.ssl, r);
+                    return err == SSL_ERROR_WANT_READ || err == SSL_ERROR_WANT_WRITE;
+                }
+                n = r;
+            } else
+#endif
+            {
+                n = read(conn.fd, buffer, sizeof(buffer));
+                if (n == 0) {
+                    return false;
+                }
+                if (n < 0) {
+                    return errno == EAGAIN || errno == EWOULDBLOCK;
+                }
+            }
+            conn.in.append(buffer, static_cast<size_t>(n));
+        }
+    }
+
+    void handle(int fd, uint32_t events) {
+        Connection* found = lookup(fd);
+        if (!found) {
+            return;
+        }
+        Connection& conn = *found;
+
+        if (conn.state == Connection::HOLD) {
+            // Only notice the client giving up
+            char buffer[512];
+            ssize_t n = read(fd, buffer, sizeof(buffer));
+            if (n == 0 || (n < 0 && errno != EAGAIN) || (events & (EPOLLRDHUP | EPOLLHUP | EPOLLERR))) {
+                closeConnection(conn, false);
+            }
+            return;
+        }
+
+#ifdef CFPINNER_MOCK_TLS
+        if (conn.state == Connection::HANDSHAKE) {
+            int r = SSL_do_handshake(conn.ssl);
+            if (r != 1) {
+                int err = SSL_get_error(conn.ssl, r);
+                if (err == SSL_ERROR_WANT_READ || err == SSL_ERROR_WANT_WRITE) {
+                    watch(conn, err == SSL_ERROR_WANT_WRITE);
+                } else {
+                    closeConnection(conn, false);
+                }
+                return;
+            }
+            conn.state = Connection::READING;
+            watch(conn, false);
+        }
+#endif
+
+        if (conn.state == Connection::WRITING && (events & EPOLLOUT)) {
+            if (!flush(conn)) {
+                return;
+            }
+        }
+
+        if (!readAvailable(conn)) {
+            closeConnection(conn, false);
+            return;
+        }
+        if (conn.state == Connection::READING) {
+            nextRequest(conn);
+        }
+    }
+
+    // Start on the next buffered request, if a complete one is there
+    void nextRequest(Connection& conn) {
+        size_t end = conn.in.find("\r\n\r\n");
+        if (end == std::string::npos) {
+            return;
+        }
+        conn.in.erase(0, end + 4);
+        g_counters.requests++;
+
+        double roll = std::uniform_real_distribution<double>(0.0, 1.0)(rng_);
+        if (roll < g_options.drop) {
+            g_counters.drops++;
+            closeConnection(conn, false);
+            return;
+        }
+        if (roll < g_options.drop + g_options.reset) {
+            g_counters.resets++;
+            closeConnection(conn, true);
+            return;
+        }
+
+        long delay_ms = g_latency.sampleMs(rng_);
+        if (delay_ms > 0) {
+            conn.state = Connection::DELAYED;
+            timers_.push({nowMs() + delay_ms, conn.fd, conn.generation});
+            return;
+        }
+        startResponse(conn);
+    }
+
+    void startResponse(Connection& conn) {
+        uint32_t ip = conn.local_ip;
+        bool hit = edgeUniform(ip, 1) < g_options.hit_ratio;
+        size_t colo = static_cast<size_t>(edgeUniform(ip, 2) * (sizeof(kColos) / sizeof(kColos[0])));
+        if (hit) {
+            g_counters.hits++;
+        }
+
+        char ray[24];
+        std::snprintf(ray, sizeof(ray), "%016llx",
+                      static_cast<unsigned long long>(mix(g_options.seed ^ ip ^ (++ray_counter_ << 32))));
+
+        conn.out = "HTTP/1.1 200 OK\r\n"
+                   "Server: cloudflare\r\n"
+                   "Content-Type: image/png\r\n"
+                   "Content-Length: 0\r\n"
+                   "CF-Cache-Status: ";
+        conn.out += hit ? "HIT" : "MISS";
+        conn.out += "\r\nCF-Ray: ";
+        conn.out += ray;
+        conn.out += "-";
+        conn.out += kColos[colo];
+        conn.out += "\r\nCF-IPCountry: ";
+        conn.out += kCountries[colo];
+        conn.out += "\r\n\r\n";
+        conn.out_pos = 0;
+        conn.state = Connection::WRITING;
+        flush(conn);
+    }
+
+    // Write pending output; returns false if the connection was closed
+    bool flush(Connection& conn) {
+        while (conn.out_pos < conn.out.size()) {
+            ssize_t n;
+            const char* data = conn.out.data() + conn.out_pos;
+            size_t size = conn.out.size() - conn.out_pos;
+#ifdef CFPINNER_MOCK_TLS
+            if (conn.ssl) {
+                int r = SSL_write(conn.ssl, data, static_cast<int>(size));
+                if (r <= 0) {
+                    int err = SSL_get_error(conn.ssl, r);
+                    if (err == SSL_ERROR_WANT_WRITE || err == SSL_ERROR_WANT_READ) {
+                        watch(conn, true);
+                        return true;
+                    }
+                    closeConnection(conn, false);
+                    return false;
+                }
+                n = r;
+            } else
+#endif
+            {
+                n = write(conn.fd, data, size);
+                if (n < 0) {
+                    if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                        watch(conn, true);
+                        return true;
+                    }
+                    closeConnection(conn, false);
+                    return false;
+                }
+            }
+            conn.out_pos += static_cast<size_t>(n);
+        }
+
+        // Keep-alive: go back to reading and serve any pipelined request
+        conn.state = Connection::READING;
+        conn.out.clear();
+        conn.out_pos = 0;
+        if (conn.want_write) {
+            watch(conn, false);
+        }
+        nextRequest(conn);
+        return lookup(conn.fd) != nullptr;
+    }
+};
+
+#ifdef CFPINNER_MOCK_TLS
+// Self-signed P-256 certificate, so the mock runs without any files
+bool generateCertificate(SSL_CTX* ctx) {
+    EVP_PKEY* key = EVP_EC_gen("P-256");
+    X509* cert = X509_new();
+    if (!key || !cert) {
+        EVP_PKEY_free(key);
+        X509_free(cert);
+        return false;
+    }
+
+    ASN1_INTEGER_set(X509_get_serialNumber(cert), 1);
+    X509_gmtime_adj(X509_getm_notBefore(cert), 0);
+    X509_gmtime_adj(X509_getm_notAfter(cert), 365L * 24 * 3600);
+    X509_set_pubkey(cert, key);
+    X509_NAME* name = X509_get_subject_name(cert);
+    X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC,
+                               reinterpret_cast<const unsigned char*>("cfpinner-mock-edge"), -1, -1, 0);
+    X509_set_issuer_name(cert, name);
+
+    bool ok = X509_sign(cert, key, EVP_sha256()) > 0 &&
+              SSL_CTX_use_certificate(ctx, cert) == 1 &&
+              SSL_CTX_use_PrivateKey(ctx, key) == 1;
+    EVP_PKEY_free(key);
+    X509_free(cert);
+    return ok;
+}
+
+bool initTLS() {
+    g_ssl_ctx = SSL_CTX_new(TLS_server_method());
+    if (!g_ssl_ctx) {
+        return false;
+    }
+    SSL_CTX_set_mode(g_ssl_ctx, SSL_MODE_ENABLE_PARTIAL_WRITE | SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
+
+    if (!g_options.cert_file.empty()) {
+        if (SSL_CTX_use_certificate_chain_file(g_ssl_ctx, g_options.cert_file.c_str()) != 1 ||
+            SSL_CTX_use_PrivateKey_file(g_ssl_ctx, g_options.key_file.c_str(), SSL_FILETYPE_PEM) != 1) {
+            std::cerr << "Failed to load certificate/key" << std::endl;
+            return false;
+        }
+        return true;
+    }
+    return generateCertificate(g_ssl_ctx);
+}
+#endif
+
+bool parseRange(const std::string& cidr) {
+    size_t slash = cidr.find('/');
+    std::string ip = cidr.substr(0, slash);
+    int prefix = slash == std::string::npos ? 32 : std::atoi(cidr.c_str() + slash + 1);
+    struct in_addr addr;
+    if (inet_pton(AF_INET, ip.c_str(), &addr) != 1 || prefix < 0 || prefix > 32) {
+        return false;
+    }
+    g_options.range_mask = prefix == 0 ? 0 : (~0U << (32 - prefix));
+    g_options.range_base = ntohl(addr.s_addr) & g_options.range_mask;
+    return true;
+}
+
+void printUsage() {
+    std::cout << "Usage: cfpinner_mock_edge [options]\n\n"
+              << "Options:\n"
+              << "  --bind <addr>          Listen address (default: 0.0.0.0)\n"
+              << "  --tls-port <port>      HTTPS port, 0 disables (default: 8443)\n"
+              << "  --http-port <port>     Plain HTTP port, 0 disables (default: 8080)\n"
+              << "  --range <cidr>         Edge addresses to serve; others get a RST\n"
+              << "                         (default: 127.0.0.0/16)\n"
+              << "  --workers <num>        Event loop threads (default: 1)\n"
+              << "  --hit-ratio <f>        Share of edges with the object cached (default: 0.1)\n"
+              << "  --blackhole <f>        Share of edges that accept and never answer\n"
+              << "  --drop <f>             Per request: close without answering\n"
+              << "  --reset <f>            Per request: abort with a TCP RST\n"
+              << "  --latency <spec>       0, fixed:MS, uniform:MIN:MAX or lognormal:MEDIAN:SIGMA\n"
+              << "  --seed <num>           Seed for the simulated network (default: 1)\n"
+              << "  --cert <pem> --key <pem>  Certificate to use instead of a generated one\n";
+}
+
+void onSignal(int) {
+    g_stop.store(true);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--help" || arg == "-h") {
+            printUsage();
+            return 0;
+        } else if (arg == "--bind" && has_value) {
+            g_options.bind_address = argv[++i];
+        } else if (arg == "--tls-port" && has_value) {
+            g_options.tls_port = static_cast<uint16_t>(std::atoi(argv[++i]));
+        } else if (arg == "--http-port" && has_value) {
+            g_options.http_port = static_cast<uint16_t>(std::atoi(argv[++i]));
+        } else if (arg == "--range" && has_value) {
+            if (!parseRange(argv[++i])) {
+                std::cerr << "Invalid range: " << argv[i] << std::endl;
+                return 1;
+            }
+        } else if (arg == "--workers" && has_value) {
+            g_options.workers = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--hit-ratio" && has_value) {
+            g_options.hit_ratio = std::atof(argv[++i]);
+        } else if (arg == "--blackhole" && has_value) {
+            g_options.blackhole = std::atof(argv[++i]);
+        } else if (arg == "--drop" && has_value) {
+            g_options.drop = std::atof(argv[++i]);
+        } else if (arg == "--reset" && has_value) {
+            g_options.reset = std::atof(argv[++i]);
+        } else if (arg == "--latency" && has_value) {
+            g_options.latency = argv[++i];
+        } else if (arg == "--seed" && has_value) {
+            g_options.seed = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--cert" && has_value) {
+            g_options.cert_file = argv[++i];
+        } else if (arg == "--key" && has_value) {
+            g_options.key_file = argv[++i];
+        } else {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            printUsage();
+            return 1;
+        }
+    }
+
+    if (!g_latency.parse(g_options.latency)) {
+        std::cerr << "Invalid latency spec: " << g_options.latency << std::endl;
+        return 1;
+    }
+
+#ifdef CFPINNER_MOCK_TLS
+    if (g_options.tls_port && !initTLS()) {
+        std::cerr << "Failed to set up TLS" << std::endl;
+        return 1;
+    }
+#else
+    if (g_options.tls_port) {
+        std::cerr << "Built without OpenSSL; serving plain HTTP only" << std::endl;
+        g_options.tls_port = 0;
+    }
+#endif
+
+    // Every simulated connection holds a descriptor
+    struct rlimit rl;
+    if (getrlimit(RLIMIT_NOFILE, &rl) == 0 && rl.rlim_cur < rl.rlim_max) {
+        rl.rlim_cur = rl.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &rl);
+    }
+
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+    std::signal(SIGPIPE, SIG_IGN);
+
+    // Each worker binds its own listeners with SO_REUSEPORT
+    std::vector<Worker> workers;
+    workers.reserve(g_options.workers);
+    for (size_t i = 0; i < g_options.workers; i++) {
+        workers.emplace_back(i);
+        if (!workers.back().init()) {
+            return 1;
+        }
+    }
+
+    std::cout << "Mock edge listening on " << g_options.bind_address;
+    if (g_options.http_port) {
+        std::cout << " http:" << g_options.http_port;
+    }
+    if (g_options.tls_port) {
+        std::cout << " https:" << g_options.tls_port;
+    }
+    std::cout << " (" << g_options.workers << " workers)" << std::endl;
+
+    std::vector<std::thread> threads;
+    for (auto& worker : workers) {
+        threads.emplace_back([&worker]() { worker.run(); });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    std::cout << "connections=" << g_counters.connections.load()
+              << " requests=" << g_counters.requests.load()
+              << " hits=" << g_counters.hits.load()
+              << " drops=" << g_counters.drops.load()
+              << " resets=" << g_counters.resets.load()
+              << " blackholed=" << g_counters.blackholed.load()
+              << " out_of_range=" << g_counters.out_of_range.load() << std::endl;
+    return 0;
+}
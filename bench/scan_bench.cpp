@@ -0,0 +1,356 @@
+// End-to-end scan benchmark.
+//
+// Starts cfpinner_mock_edge (unless --no-server), then runs scanAliveNodes
+// and/or track against it once per concurrency level. Every run happens in a
+// forked child so its peak RSS can be measured on its own. Reports probes/sec,
+// p50/p99 probe latency and peak RSS per level.
+//
+//   cfpinner_bench --range 127.0.0.0/20 --concurrency 10,100,1000 -- --latency lognormal:20:0.5
+//
+// Arguments after "--" are passed to the mock edge server.
+
+#include "cdn_tracker.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <signal.h>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace cfpinner;
+
+namespace {
+
+struct BenchOptions {
+    std::string mode = "both";       // alive, track or both
+    bool use_engine = true;          // probe engine (in-flight limit) or threads
+    bool adaptive = false;           // --adaptive-concurrency on the engine
+    std::vector<size_t> levels = {10, 100, 1000};
+    std::string range = "127.0.0.0/22";
+    int port = 8443;
+    bool plain_http = false;
+    long timeout_ms = 2000;
+    unsigned retries = 0;
+    std::string server_path;         // Empty: next to this binary
+    bool spawn_server = true;
+    std::vector<std::string> server_args;
+};
+
+// What a child run reports back through the pipe
+struct RunResult {
+    size_t probes;
+    size_t succeeded;
+    size_t hits;
+    double seconds;
+    double p50_ms;
+    double p99_ms;
+};
+
+double percentileMs(std::vector<long>& samples_us, double percentile) {
+    if (samples_us.empty()) {
+        return 0.0;
+    }
+    size_t index = std::min(samples_us.size() - 1, static_cast<size_t>(percentile * samples_us.size()));
+    std::nth_element(samples_us.begin(), samples_us.begin() + index, samples_us.end());
+    return samples_us[index] / 1000.0;
+}
+
+std::string writeRangesFile(const std::string& range) {
+    char path[] = "/tmp/cfpinner_bench_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) {
+        return "";
+    }
+    std::string line = range + "\n";
+    ssize_t written = write(fd, line.data(), line.size());
+    close(fd);
+    return written == static_cast<ssize_t>(line.size()) ? path : "";
+}
+
+// Runs in the child: one scan at one concurrency level
+RunResult runScan(const BenchOptions& options, const std::string& mode, size_t level,
+                  const std::string& ranges_file) {
+    std::string scheme = options.plain_http ? "http" : "https";
+    std::string port = ":" + std::to_string(options.port);
+
+    CDNTracker tracker;
+    tracker.loadIPRanges(ranges_file);
+    tracker.setForceAll(true);
+    tracker.setTimeoutMs(0, options.timeout_ms);
+    tracker.setRetries(options.retries);
+    tracker.setAliveURL(scheme + "://www.cloudflare.com" + port + "/");
+    if (options.use_engine) {
+        tracker.setMaxInFlight(level);
+        tracker.setAdaptiveConcurrency(options.adaptive);
+    }
+
+    std::mutex mutex;
+    std::vector<long> latencies_us;
+    RunResult result = {};
+    tracker.setProbeObserver([&](const ProbeRequest&, const HTTPResponse& response) {
+        std::lock_guard<std::mutex> lock(mutex);
+        result.probes++;
+        if (response.success) {
+            result.succeeded++;
+            latencies_us.push_back(response.total_time_us);
+        }
+        if (response.is_cache_hit) {
+            result.hits++;
+        }
+    });
+
+    size_t threads = options.use_engine ? 1 : level;
+    auto start = std::chrono::steady_clock::now();
+    if (mode == "alive") {
+        tracker.scanAliveNodes(threads);
+    } else {
+        tracker.track("bench", scheme + "://bench.example" + port + "/image.png", threads);
+    }
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    result.p50_ms = percentileMs(latencies_us, 0.50);
+    result.p99_ms = percentileMs(latencies_us, 0.99);
+    return result;
+}
+
+// Fork, run the scan with stdout silenced, and collect the child's peak RSS
+bool runIsolated(const BenchOptions& options, const std::string& mode, size_t level,
+                 const std::string& ranges_file, RunResult& result, long& max_rss_kb) {
+    int fds[2];
+    if (pipe(fds) != 0) {
+        return false;
+    }
+
+    std::cout.flush();
+    pid_t pid = fork();
+    if (pid < 0) {
+        return false;
+    }
+    if (pid == 0) {
+        close(fds[0]);
+        int devnull = open("/dev/null", O_WRONLY);
+        dup2(devnull, STDOUT_FILENO);
+        RunResult child_result = runScan(options, mode, level, ranges_file);
+        ssize_t written = write(fds[1], &child_result, sizeof(child_result));
+        _exit(written == sizeof(child_result) ? 0 : 1);
+    }
+
+    close(fds[1]);
+    ssize_t got = read(fds[0], &result, sizeof(result));
+    close(fds[0]);
+
+    int status = 0;
+    struct rusage usage;
+    wait4(pid, &status, 0, &usage);
+    max_rss_kb = usage.ru_maxrss;
+    return got == sizeof(result) && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+bool waitForServer(const std::string& range, int port) {
+    // First host address of the range
+    std::string base = range.substr(0, range.find('/'));
+    struct sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(port));
+    if (inet_pton(AF_INET, base.c_str(), &addr.sin_addr) != 1) {
+        return false;
+    }
+    addr.sin_addr.s_addr = htonl(ntohl(addr.sin_addr.s_addr) + 1);
+
+    for (int attempt = 0; attempt < 50; attempt++) {
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+        int rc = connect(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr));
+        close(fd);
+        if (rc == 0) {
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    return false;
+}
+
+pid_t spawnServer(const BenchOptions& options, const char* argv0) {
+    std::string path = options.server_path;
+    if (path.empty()) {
+        std::string self = argv0;
+        size_t slash = self.rfind('/');
+        path = (slash == std::string::npos ? std::string(".") : self.substr(0, slash)) + "/cfpinner_mock_edge";
+    }
+
+    std::vector<std::string> args = {path, "--range", options.range};
+    args.push_back(options.plain_http ? "--http-port" : "--tls-port");
+    args.push_back(std::to_string(options.port));
+    args.push_back(options.plain_http ? "--tls-port" : "--http-port");
+    args.push_back("0");
+    args.insert(args.end(), options.server_args.begin(), options.server_args.end());
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        std::vector<char*> argv;
+        for (auto& arg : args) {
+            argv.push_back(const_cast<char*>(arg.c_str()));
+        }
+        argv.push_back(nullptr);
+        execv(path.c_str(), argv.data());
+        std::cerr << "Failed to start " << path << ": " << std::strerror(errno) << std::endl;
+        _exit(127);
+    }
+    return pid;
+}
+
+std::vector<size_t> parseLevels(const std::string& list) {
+    std::vector<size_t> levels;
+    std::stringstream stream(list);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        if (!item.empty()) {
+            levels.push_back(std::stoul(item));
+        }
+    }
+    return levels;
+}
+
+void printUsage() {
+    std::cout << "Usage: cfpinner_bench [options] [-- mock edge options]\n\n"
+              << "Options:\n"
+              << "  --mode <alive|track|both>   Which scan to benchmark (default: both)\n"
+              << "  --threads                   Use worker threads; levels are thread counts\n"
+              << "  --adaptive-concurrency      Let the engine tune in-flight probes (levels are ceilings)\n"
+              << "  --concurrency <list>        Comma-separated levels (default: 10,100,1000)\n"
+              << "  --range <cidr>              Loopback range to scan (default: 127.0.0.0/22)\n"
+              << "  --port <port>               Edge port (default: 8443)\n"
+              << "  --http                      Plain HTTP instead of HTTPS\n"
+              << "  --timeout-ms <ms>           Probe timeout (default: 2000)\n"
+              << "  --retries <num>             Retry rounds for transient failures (default: 0)\n"
+              << "  --server <path>             Mock edge binary (default: next to this one)\n"
+              << "  --no-server                 Use an already running mock edge\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    BenchOptions options;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--") {
+            options.server_args.assign(argv + i + 1, argv + argc);
+            break;
+        } else if (arg == "--help" || arg == "-h") {
+            printUsage();
+            return 0;
+        } else if (arg == "--mode" && has_value) {
+            options.mode = argv[++i];
+        } else if (arg == "--threads") {
+            options.use_engine = false;
+        } else if (arg == "--adaptive-concurrency") {
+            options.adaptive = true;
+        } else if (arg == "--concurrency" && has_value) {
+            options.levels = parseLevels(argv[++i]);
+        } else if (arg == "--range" && has_value) {
+            options.range = argv[++i];
+        } else if (arg == "--port" && has_value) {
+            options.port = std::atoi(argv[++i]);
+        } else if (arg == "--http") {
+            options.plain_http = true;
+        } else if (arg == "--timeout-ms" && has_value) {
+            options.timeout_ms = std::atol(argv[++i]);
+        } else if (arg == "--retries" && has_value) {
+            options.retries = static_cast<unsigned>(std::atoi(argv[++i]));
+        } else if (arg == "--server" && has_value) {
+            options.server_path = argv[++i];
+        } else if (arg == "--no-server") {
+            options.spawn_server = false;
+        } else {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            printUsage();
+            return 1;
+        }
+    }
+
+    std::vector<std::string> modes;
+    if (options.mode == "alive" || options.mode == "both") {
+        modes.push_back("alive");
+    }
+    if (options.mode == "track" || options.mode == "both") {
+        modes.push_back("track");
+    }
+    if (modes.empty() || options.levels.empty()) {
+        printUsage();
+        return 1;
+    }
+
+    std::string ranges_file = writeRangesFile(options.range);
+    if (ranges_file.empty()) {
+        std::cerr << "Failed to write ranges file" << std::endl;
+        return 1;
+    }
+
+    pid_t server = -1;
+    if (options.spawn_server) {
+        server = spawnServer(options, argv[0]);
+    }
+    if (!waitForServer(options.range, options.port)) {
+        std::cerr << "Mock edge is not accepting connections on port " << options.port << std::endl;
+        if (server > 0) {
+            kill(server, SIGTERM);
+            waitpid(server, nullptr, 0);
+        }
+        unlink(ranges_file.c_str());
+        return 1;
+    }
+
+    std::cout << "\nBenchmark: " << options.range << " over " << (options.plain_http ? "HTTP" : "HTTPS")
+              << ", " << (options.use_engine ? (options.adaptive ? "adaptive engine" : "probe engine") : "threads")
+              << ", timeout " << options.timeout_ms << "ms\n" << std::endl;
+    std::cout << std::left << std::setw(7) << "mode" << std::right
+              << std::setw(8) << "level" << std::setw(9) << "probes" << std::setw(8) << "ok%"
+              << std::setw(7) << "hits" << std::setw(11) << "probes/s" << std::setw(9) << "p50ms"
+              << std::setw(9) << "p99ms" << std::setw(10) << "rss(MB)" << std::endl;
+
+    int exit_code = 0;
+    for (const auto& mode : modes) {
+        for (size_t level : options.levels) {
+            RunResult result = {};
+            long max_rss_kb = 0;
+            if (!runIsolated(options, mode, level, ranges_file, result, max_rss_kb)) {
+                std::cerr << mode << " at " << level << ": run failed" << std::endl;
+                exit_code = 1;
+                continue;
+            }
+
+            double ok_percent = result.probes ? 100.0 * result.succeeded / result.probes : 0.0;
+            double rate = result.seconds > 0 ? result.probes / result.seconds : 0.0;
+            std::cout << std::left << std::setw(7) << mode << std::right << std::fixed
+                      << std::setw(8) << level << std::setw(9) << result.probes
+                      << std::setw(8) << std::setprecision(1) << ok_percent
+                      << std::setw(7) << result.hits
+                      << std::setw(11) << std::setprecision(0) << rate
+                      << std::setw(9) << std::setprecision(1) << result.p50_ms
+                      << std::setw(9) << result.p99_ms
+                      << std::setw(10) << max_rss_kb / 1024.0 << std::endl;
+        }
+    }
+    std::cout << std::endl;
+
+    if (server > 0) {
+        kill(server, SIGTERM);
+        waitpid(server, nullptr, 0);
+    }
+    unlink(ranges_file.c_str());
+    return exit_code;
+}
@@ -0,0 +1,86 @@
+#ifndef ALIVE_INDEX_H
+#define ALIVE_INDEX_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace cfpinner {
+
+// One alive edge IP as stored in the index
+struct AliveRecord {
+    uint32_t ip;           // IPv4 in host byte order (sort key)
+    uint32_t last_seen;    // Unix time the IP last answered
+    uint32_t rtt_us;       // TCP connect time (about one round trip), 0 = unknown
+    uint16_t iata;         // Colo as ResultStore::encodeIATA code, 0 = unknown
+    uint16_t status_code;  // HTTP status of the last probe
+};
+static_assert(sizeof(AliveRecord) == 16, "AliveRecord is part of the file format");
+
+// Versioned binary file of alive edges: a 32-byte header followed by
+// AliveRecords sorted by IP, in native byte order. The file is mapped
+// read-only and the records are used in place, so loading costs no parsing
+// and lookups are binary searches. Files in the older text format
+// ("<ip> [<iata>]" per line) can still be imported into memory.
+class AliveIndex {
+public:
+    static const uint32_t VERSION = 1;
+
+    AliveIndex();
+    ~AliveIndex();
+
+    AliveIndex(const AliveIndex&) = delete;
+    AliveIndex& operator=(const AliveIndex&) = delete;
+
+    // Whether path starts with the index header (as opposed to a text list)
+    static bool isIndexFile(const std::string& path);
+
+    // Map an index file; returns false if missing, truncated or of another version
+    bool open(const std::string& path);
+
+    // Load a text list instead (legacy alive_ips.txt or an export).
+    // Lines without a last-seen time take the file's modification time.
+    bool importText(const std::string& path);
+
+    void close();
+
+    const AliveRecord* begin() const { return records_; }
+    const AliveRecord* end() const { return records_ + count_; }
+    size_t size() const { return count_; }
+    bool empty() const { return count_ == 0; }
+
+    // Unix time the index was written (0 for imported text)
+    uint64_t created() const { return created_; }
+
+    // Record of ip, or nullptr; O(log n)
+    const AliveRecord* find(uint32_t ip) const;
+
+    // Whether a record was seen within ttl_seconds of now (0 = never expires)
+    static bool isFresh(const AliveRecord& record, uint64_t now, uint32_t ttl_seconds) {
+        return ttl_seconds == 0 || record.last_seen + static_cast<uint64_t>(ttl_seconds) > now;
+    }
+
+    // Number of records seen within ttl_seconds (0 = all)
+    size_t freshCount(uint32_t ttl_seconds) const;
+
+    // Write records as an index file, sorted and with one record per IP
+    // (the most recently seen wins). Written to a temporary file and renamed,
+    // so readers never see a partial index.
+    static bool write(const std::string& path, std::vector<AliveRecord> records);
+
+    // Write the records as text, one "<ip> <iata> <rtt_ms> <status> <last_seen>" line each
+    bool exportText(const std::string& path) const;
+
+private:
+    void* mapping_;
+    size_t mapping_size_;
+    std::vector<AliveRecord> imported_;  // Backing store for importText
+    const AliveRecord* records_;
+    size_t count_;
+    uint64_t created_;
+};
+
+} // namespace cfpinner
+
+#endif // ALIVE_INDEX_H
@@ -0,0 +1,53 @@
+#ifndef BUFFERED_WRITER_H
+#define BUFFERED_WRITER_H
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+namespace cfpinner {
+
+// Append-only file writer with one large buffer. Data is handed to the
+// kernel with write(2) only when the buffer fills up or on flush(), so
+// writing many small records costs a memcpy each and no syscalls.
+// Not thread-safe; meant for a single consumer thread.
+class BufferedWriter {
+public:
+    static const size_t DEFAULT_CAPACITY = 1 << 20;
+
+    explicit BufferedWriter(size_t capacity = DEFAULT_CAPACITY);
+    ~BufferedWriter();
+
+    BufferedWriter(const BufferedWriter&) = delete;
+    BufferedWriter& operator=(const BufferedWriter&) = delete;
+
+    // Create or truncate path ("-" writes to stdout)
+    bool open(const std::string& path);
+
+    void append(const char* data, size_t length);
+    void append(const std::string& data) { append(data.data(), data.size()); }
+    void put(char c);
+
+    // Write everything buffered; false once any write has failed
+    bool flush();
+
+    // Flush and close; returns whether every write succeeded
+    bool close();
+
+    bool isOpen() const { return fd_ >= 0; }
+    size_t bytesWritten() const { return bytes_written_; }
+
+private:
+    std::vector<char> buffer_;
+    size_t used_;
+    int fd_;
+    bool owns_fd_;
+    bool failed_;
+    size_t bytes_written_;
+
+    void writeOut(const char* data, size_t length);
+};
+
+} // namespace cfpinner
+
+#endif // BUFFERED_WRITER_H
@@ -3,22 +3,39 @@
 
 #include <string>
 #include <vector>
+#include <functional>
+#include <memory>
+#include <atomic>
 #include "http_client.h"
+#include "probe_engine.h"
+#include "ip_range_list.h"
+#include "result_store.h"
+#include "colo_selector.h"
+#include "scan_metrics.h"
 
 namespace cfpinner {
 
-struct CDNCheckResult {
-    std::string ip_range;
-    std::string ip_address;
-    bool is_hit;
-    int status_code;
-    std::string cache_status;
-    std::string cf_ray;
-    std::string cf_iata_code;
-    std::string cf_ip_country;
-    std::string error_message;
+class ResultSink;
+class Dashboard;
+class ScanCheckpoint;
+
+// One image to track and the URL it was uploaded to
+struct TrackJob {
+    std::string identifier;
+    std::string url;
+};
+
+// Cadence of CDNTracker::watch
+struct WatchOptions {
+    unsigned interval_s = 60;       // Re-probe interval per edge
+    unsigned max_interval_s = 960;  // Ceiling for edges whose URLs are all HIT
+    unsigned duration_s = 0;        // Stop after this long (0 = until SIGINT/SIGTERM)
+    std::string log_file;           // Append transitions as tab-separated lines
 };
 
+// Builds the probes for one edge IP (one per URL being checked)
+using ProbeBuilder = std::function<void(const std::string& ip_address, std::vector<ProbeRequest>& requests)>;
+
 class CDNTracker {
 public:
     CDNTracker();
@@ -28,13 +45,46 @@ public:
     // Uses multi-threading for fast scanning (default: 10 threads)
     void track(const std::string& identifier, const std::string& target_url, size_t num_threads = 10);
 
-    // Scan all Cloudflare IPs to find alive nodes (returns list of responsive IPs)
+    // Track several URLs (e.g. an image and its resized variants) in one pass.
+    // With the probe engine, all URLs for an edge share one HTTP/2 connection.
+    void track(const std::string& identifier, const std::vector<std::string>& target_urls, size_t num_threads = 10);
+
+    // Track many images in one pass: every edge IP is visited once and gets
+    // the requests of all jobs back-to-back on the same connection, so cost
+    // grows with the number of edges rather than edges x jobs. Results are
+    // shown grouped by identifier.
+    void track(const std::vector<TrackJob>& jobs, size_t num_threads = 10);
+
+    // Keep probing the jobs' URLs and report cache status transitions
+    // (e.g. MISS -> HIT, HIT -> EXPIRED) with timestamps. A timer wheel
+    // re-probes each edge on its own schedule: every interval while any URL
+    // is not HIT, doubling up to max_interval while all are.
+    void watch(const std::vector<TrackJob>& jobs, const WatchOptions& options, size_t num_threads = 10);
+
+    // Scan all Cloudflare IPs to find alive nodes (returns the responsive IPs
+    // with the colo each answered from, its RTT and status)
     // Uses multi-threading for fast scanning (default: 10 threads)
-    std::vector<std::string> scanAliveNodes(size_t num_threads = 10);
+    std::vector<AliveRecord> scanAliveNodes(size_t num_threads = 10);
+
+    // Bring an alive index up to date without a full scan: re-probe the
+    // entries older than ttl_seconds and up to dead_sample addresses of the
+    // ranges that are not in it. Returns the merged records; stale entries
+    // that no longer answer are dropped.
+    std::vector<AliveRecord> refreshAliveNodes(const AliveIndex& index, uint32_t ttl_seconds,
+                                               size_t dead_sample, size_t num_threads = 10);
 
     // Set custom timeout for HTTP requests (in seconds)
     void setTimeout(int timeout_seconds);
 
+    // Set connect and total timeouts for HTTP requests in milliseconds
+    // (connect 0 = bounded by the total timeout only)
+    void setTimeoutMs(long connect_timeout_ms, long timeout_ms);
+
+    // Size each probe's deadlines from measured RTTs: multiplier x p99 of the
+    // connect/total times seen so far in the probe's /16 block. The timeouts
+    // set above remain the ceiling.
+    void setAdaptiveTimeout(bool enabled, double multiplier = 4.0);
+
     // Enable force-all mode (expand all CIDR ranges completely)
     void setForceAll(bool force_all);
 
@@ -44,28 +94,174 @@ public:
     // Load specific IPs to check (for using alive list)
     void setSpecificIPs(const std::vector<std::string>& ips);
 
+    // Check the IPs of an alive index seen within ttl_seconds (0 = all);
+    // their colos feed setPerColo and the fastest IPs are probed first
+    void setAliveIndex(const AliveIndex& index, uint32_t ttl_seconds = 0);
+
+    // Track with at most per_colo IPs of each colo known from the alive list,
+    // failing over to another IP of the colo when one errors (0 = every IP)
+    void setPerColo(size_t per_colo);
+
     // Set the target domain to check
     void setTargetDomain(const std::string& domain);
 
+    // Probe only shard index (0-based) out of count of the addresses expanded
+    // from the ranges, so count hosts can split a scan without coordinating
+    // (see IPRangeList::shard). The alive list is not sharded.
+    void setShard(size_t index, size_t count);
+
     // Set max IPs to check per CIDR range
     // Default: 10 for tracking, 100 for alive scan
     void setMaxIPsPerRange(size_t max_ips);
 
+    // Use the event-driven probe engine with up to max_in_flight concurrent probes
+    // instead of worker threads (0 keeps the thread mode)
+    void setMaxInFlight(size_t max_in_flight);
+
+    // Let the probe engine find the in-flight limit on its own: ramp up while
+    // error rate and latency stay flat, back off when they degrade.
+    // The max in-flight setting (default 4096) becomes the ceiling.
+    void setAdaptiveConcurrency(bool enabled);
+
+    // Retry probes that failed transiently (timeouts, resets) up to max_retries
+    // times in rounds after the main pass, with exponential backoff between
+    // rounds. budget_percent caps the total retries as a share of the first pass.
+    void setRetries(unsigned max_retries, double budget_percent = 10.0);
+
+    // URL probed by the alive scan (default: https://www.cloudflare.com/).
+    // Its port is also the one the connect-scan pre-pass dials.
+    void setAliveURL(const std::string& url);
+
+    // Called for every finished probe, retries included, possibly
+    // concurrently from several threads (used by the benchmark)
+    void setProbeObserver(ProbeCallback observer);
+
+    // Pre-filter the alive scan with connect-only TCP probes to :443
+    // and run the HEAD check only on IPs that accepted the connection
+    void setConnectScan(bool enabled, int timeout_ms = 500);
+
+    // Keep each URL's hostname (and SNI) and route probes to the edge IP with
+    // CURLOPT_CONNECT_TO instead of rewriting the URL to https://<ip>/...
+    void setPinConnect(bool enabled);
+
+    // Record every probe (starts, results, errors, latencies) into metrics,
+    // which must outlive the scans (nullptr disables)
+    void setMetrics(ScanMetrics* metrics);
+
+    // Stream every result of track, watch and alive scans into sink as it
+    // arrives, from the result consumer thread (nullptr disables)
+    void setResultSink(ResultSink* sink);
+
+    // After tracking, list every probed IP instead of per-colo totals
+    void setShowIPTable(bool enabled);
+
+    // Show track and alive scans on a full-screen dashboard instead of
+    // printing each result (nullptr disables)
+    void setDashboard(Dashboard* dashboard);
+
+    // Keep the progress of full alive scans (probed IPs and alive records so
+    // far) in a checkpoint file, saved every interval_s seconds and when
+    // SIGINT/SIGTERM stops the scan. With resume, an existing checkpoint of
+    // the same scan is loaded and only the IPs it has not probed are scanned.
+    void setCheckpoint(const std::string& path, unsigned interval_s = 30, bool resume = false);
+
+    // Whether the last alive scan was stopped by SIGINT/SIGTERM; its results
+    // are then partial and only kept in the checkpoint
+    bool interrupted() const { return interrupted_; }
+
 private:
     std::vector<std::string> ip_ranges_;
-    std::vector<std::string> specific_ips_; // For using alive list
+    std::vector<AliveRecord> specific_ips_; // For using alive list
     std::string target_domain_;
     HTTPClient http_client_;
     size_t max_ips_per_range_;
     bool use_specific_ips_;
     bool force_all_;
-    int timeout_seconds_;
+    size_t shard_index_;
+    size_t shard_count_;
+    long timeout_ms_;
+    long http_connect_timeout_ms_;
+    bool adaptive_timeout_;
+    double rtt_multiplier_;
+    size_t max_in_flight_;
+    std::shared_ptr<CurlShare> curl_share_; // Shared by all probes of this tracker
+    bool connect_scan_;
+    bool pin_connect_;
+    int connect_scan_timeout_ms_;
+    bool adaptive_concurrency_;
+    // Copied from the controller of a running adaptive scan (limit 0 when
+    // none), so the result consumer never holds on to the controller itself
+    std::atomic<size_t> concurrency_limit_;
+    std::atomic<const char*> concurrency_action_;
+    unsigned max_retries_;
+    double retry_budget_percent_;
+    std::string alive_url_;
+    ProbeCallback probe_observer_;
+    size_t per_colo_;
+    ScanMetrics* metrics_;
+    ResultSink* result_sink_;
+    bool show_ip_table_;
+    Dashboard* dashboard_;
+    std::string checkpoint_path_;
+    unsigned checkpoint_interval_s_;
+    bool resume_;
+    bool interrupted_;
 
-    void displayResult(const CDNCheckResult& result) const;
-    void displaySummary(const std::vector<CDNCheckResult>& results) const;
+    // One result line; label replaces the cache status if given
+    void displayResult(const ResultStore& results, size_t index, const char* label = nullptr) const;
+    void displaySummary(const ResultStore& results) const;
     void displayProgress(size_t current, size_t total) const;
-    void displayResultsTable(const std::vector<CDNCheckResult>& results) const;
-    std::vector<std::string> expandAllRanges() const;
+
+    // Results of one URL, or (url_index < 0) all of them: per colo, or per IP
+    // if enabled with setShowIPTable
+    void displayResults(const ResultStore& results, int url_index = -1) const;
+    void displayResultsTable(const ResultStore& results, int url_index = -1) const;
+    void displayColoSummary(const ResultStore& results, int url_index = -1) const;
+    void displayCounts(const ResultStore::Counts& counts) const;
+    IPRangeList expandAllRanges() const;
+
+    // Targets of the alive scan (100 per range unless force-all)
+    IPRangeList expandAliveRanges();
+
+    // IPs to track: the alive list (or per-colo representatives of it, in
+    // which case colo_selector is set) or the expanded ranges
+    IPRangeList selectTrackTargets(std::unique_ptr<ColoSelector>& colo_selector);
+
+    // HEAD-check ips against the alive URL and return those that answered;
+    // with a checkpoint, probed IPs and alive records are added to it and
+    // the records returned include the ones it already held
+    std::vector<AliveRecord> probeAliveNodes(const IPRangeList& ips, size_t num_threads,
+                                             ScanCheckpoint* checkpoint = nullptr);
+
+    // IPs that accept a TCP connection; the others are marked done in checkpoint
+    IPRangeList connectScan(const IPRangeList& ips, ScanCheckpoint* checkpoint = nullptr);
+
+    // Identifies the targets of a full alive scan, for checkpoints
+    uint64_t aliveScanKey() const;
+
+    // Whether probes run on the probe engine, and its in-flight ceiling
+    bool useProbeEngine() const { return max_in_flight_ > 0 || adaptive_concurrency_; }
+    size_t engineInFlight() const;
+    void displayConcurrency(size_t num_threads) const;
+
+    // Probe every IP, either on num_threads blocking workers or on the
+    // probe engine, then retry transient failures. on_result is called once
+    // per probe, possibly concurrently from several threads. Once a signal
+    // caught by watch or a checkpointed scan arrives, no new probes start.
+    // With multiplex, the engine runs an edge's probes as HTTP/2 streams
+    // over one connection.
+    void runProbes(const IPRangeList& ips,
+                   const ProbeBuilder& build_requests,
+                   const ProbeCallback& on_result,
+                   size_t num_threads,
+                   bool multiplex = false);
+
+    // A single pass over ips without retries
+    void runProbePass(const IPRangeList& ips,
+                      const ProbeBuilder& build_requests,
+                      const ProbeCallback& on_result,
+                      size_t num_threads,
+                      bool multiplex);
 };
 
 } // namespace cfpinner
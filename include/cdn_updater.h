@@ -3,6 +3,7 @@
 
 #include <string>
 #include <vector>
+#include "alive_index.h"
 
 namespace cfpinner {
 
@@ -20,28 +21,44 @@ public:
     // Get the path to the IP ranges file
     std::string getIPRangesFilePath() const;
 
-    // Get the path to the alive IPs file
+    // Get the path to the alive IPs index
     std::string getAliveIPsFilePath() const;
 
+    // Get the path of the alive IPs text list (legacy format, default export)
+    std::string getAliveIPsTextPath() const;
+
+    // Get the path of the checkpoint kept while a full alive scan runs
+    std::string getCheckpointFilePath() const;
+
     // Get file age in days
     int getFileAgeDays() const;
 
     // Get alive IPs file age in days
     int getAliveIPsAgeDays() const;
 
-    // Save list of alive IPs to file
-    bool saveAliveIPs(const std::vector<std::string>& alive_ips);
+    // Save alive IPs with their metadata to the binary index
+    bool saveAliveIPs(const std::vector<AliveRecord>& alive_records);
 
-    // Load list of alive IPs from file
-    bool loadAliveIPs(std::vector<std::string>& alive_ips);
+    // Map the alive index read-only; falls back to importing the text list
+    bool loadAliveIPs(AliveIndex& index);
 
-    // Check if alive IPs file exists and is recent (< 7 days)
+    // Write the alive index as a text list (default: getAliveIPsTextPath())
+    bool exportAliveIPs(const std::string& path = "");
+
+    // Check if any alive IP was seen within the TTL
     bool hasRecentAliveIPs() const;
 
+    // How long an alive IP stays valid after it last answered (default: 7 days)
+    void setAliveTTL(uint32_t ttl_seconds);
+    uint32_t getAliveTTL() const { return alive_ttl_; }
+
 private:
     std::string config_dir_;
     std::string ip_ranges_file_;
     std::string alive_ips_file_;
+    std::string alive_index_file_;
+    std::string checkpoint_file_;
+    uint32_t alive_ttl_;
 
     bool downloadIPRanges(std::vector<std::string>& ipv4_ranges);
     bool saveIPRanges(const std::vector<std::string>& ipv4_ranges);
@@ -0,0 +1,62 @@
+#ifndef CF_HEADER_PARSER_H
+#define CF_HEADER_PARSER_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace cfpinner {
+
+struct HTTPResponse;
+
+// Cloudflare headers captured from one response, stored inline
+struct CFHeaders {
+    char cache_status[16];  // CF-Cache-Status, e.g. "HIT"
+    char ray[40];           // CF-Ray, e.g. "8428f15b8a9c1234-SJC"
+    char iata_code[4];      // Colo code taken from the CF-Ray suffix
+    char ip_country[4];     // CF-IPCountry, e.g. "US"
+};
+
+// Streaming parser for the headers delivered by curl's header callback.
+// Each line is matched case-insensitively against a fixed keyword table as it
+// arrives, so HTTP/2's lowercase names are handled and nothing is buffered or
+// allocated. Once every wanted header has been seen, later lines are skipped.
+class CFHeaderParser {
+public:
+    enum Field : uint8_t {
+        FIELD_CACHE_STATUS = 1 << 0,
+        FIELD_RAY          = 1 << 1,
+        FIELD_IP_COUNTRY   = 1 << 2,
+        FIELD_ALL          = FIELD_CACHE_STATUS | FIELD_RAY | FIELD_IP_COUNTRY
+    };
+
+    CFHeaderParser();
+
+    // Forget everything captured so far
+    void reset();
+
+    // Feed one raw header line (including its CRLF).
+    // A new status line resets the parser so redirects report the final response.
+    void feedLine(const char* line, size_t length);
+
+    // True once every wanted header has been captured
+    bool complete() const { return found_ == FIELD_ALL; }
+
+    // Bitmask of captured fields
+    uint8_t found() const { return found_; }
+
+    const CFHeaders& headers() const { return headers_; }
+
+    // Copy the captured headers into a response
+    void apply(HTTPResponse& response) const;
+
+    // curl CURLOPT_HEADERFUNCTION adapter; userdata must be a CFHeaderParser*
+    static size_t curlCallback(char* buffer, size_t size, size_t nitems, void* userdata);
+
+private:
+    CFHeaders headers_;
+    uint8_t found_;
+};
+
+} // namespace cfpinner
+
+#endif // CF_HEADER_PARSER_H
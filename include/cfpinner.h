@@ -2,9 +2,51 @@
 #define CFPINNER_H
 
 #include <string>
+#include <vector>
+#include <cstddef>
 
 namespace cfpinner {
 
+struct TrackJob;
+
+// Options shared by the scanning commands (--alive, --track)
+struct ScanOptions {
+    int timeout = -1;          // Seconds per request, -1 means command default
+    long timeout_ms = -1;      // Total timeout in milliseconds, overrides timeout
+    long connect_timeout_ms = -1; // TCP connect timeout in milliseconds (-1 = unset)
+    bool adaptive_timeout = false; // Derive per-probe deadlines from measured RTT
+    double rtt_multiplier = 4.0;
+    bool force_all = false;    // Expand full CIDR ranges
+    size_t shard_index = 0;    // --shard i/N: this host's part (0-based here, 1-based on the command line)
+    size_t shard_count = 1;
+    size_t num_threads = 10;   // Worker threads for blocking probes
+    size_t max_in_flight = 0;  // Concurrent probes for the async engine (0 = use threads)
+    bool adaptive_concurrency = false; // Let the async engine pick the in-flight limit
+    unsigned retries = 1;      // Retry rounds for transient probe failures
+    double retry_budget = 10.0; // Max retries as a percentage of first-pass probes
+    bool connect_scan = false; // TCP connect pre-pass for --alive
+    bool pin_connect = false;  // Route to edges with CONNECT_TO, keeping the hostname
+    size_t per_colo = 0;       // IPs probed per colo by --track (0 = every IP)
+    bool show_table = false;   // --track: list every IP instead of per-colo totals
+    bool tui = false;          // Full-screen ncurses dashboard while scanning
+    bool refresh = false;      // --alive: update the cache instead of a full scan
+    double ttl_hours = 168;    // How long an alive IP stays cached after it answered (0 = forever)
+    size_t dead_sample = 256;  // --refresh: uncached addresses probed for new nodes
+    bool resume = false;       // --alive: continue the scan saved in the checkpoint
+    unsigned checkpoint_interval = 30; // --alive: seconds between checkpoint saves
+    bool checkpoint = false;   // --alive: checkpoint a sampled scan too (--resume, --checkpoint-interval)
+    bool watch = false;        // Keep re-probing and report cache status transitions
+    unsigned watch_interval = 60;      // --watch: seconds between probes of an edge
+    unsigned watch_max_interval = 960; // --watch: backoff ceiling for edges that are HIT
+    unsigned watch_duration = 0;       // --watch: stop after this many seconds (0 = Ctrl+C)
+    std::string watch_log;             // --watch: append transitions to this file
+    std::string metrics_dir;   // Write live metrics (Prometheus textfile and JSON) here
+    unsigned metrics_interval = 15;    // Seconds between metrics exports
+    std::string output_file;   // Stream results here as they arrive ("-" = stdout)
+    std::string output_format; // ndjson, csv or binary (default: from the file extension)
+    std::vector<std::string> extra_urls; // Additional URLs to check with --track
+};
+
 class Application {
 public:
     Application();
@@ -16,9 +58,15 @@ private:
     void printUsage() const;
     void printBanner() const;
     int handleGenerate(const std::string& output_dir = "");
-    int handleTrack(const std::string& identifier, const std::string& url, int timeout = 5, bool force_all = false, size_t num_threads = 10);
+    int handleTrack(const std::string& identifier, const std::string& url, const ScanOptions& options);
+    int handleBatch(const std::string& job_file, const ScanOptions& options);
     int handleUpdateCDN();
-    int handleAlive(int timeout = 1, bool force_all = false, size_t num_threads = 10);
+    int handleAlive(const ScanOptions& options);
+    int handleExportAlive(const std::string& output_file);
+    int handleMerge(const std::string& output_file, const std::vector<std::string>& inputs);
+
+    // Load ranges or the alive cache, configure a tracker and run the jobs
+    int runTrack(const std::vector<TrackJob>& jobs, const ScanOptions& options);
 };
 
 } // namespace cfpinner
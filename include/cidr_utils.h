@@ -11,6 +11,7 @@ class CIDRUtils {
 public:
     // Expand a CIDR notation to a list of IP addresses
     // Returns a sample of IPs if the range is too large (e.g., /13 would be 500k+ IPs)
+    // Scans should use IPRangeList, which produces the same addresses lazily
     static std::vector<std::string> expandCIDR(const std::string& cidr, size_t max_ips = 256);
 
     // Parse CIDR notation into base IP and prefix length
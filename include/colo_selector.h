@@ -0,0 +1,52 @@
+#ifndef COLO_SELECTOR_H
+#define COLO_SELECTOR_H
+
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include <cstddef>
+#include "ip_range_list.h"
+#include "alive_index.h"
+
+namespace cfpinner {
+
+class ResultStore;
+
+// Picks a few representative IPs per colo so tracking probes each location
+// instead of every edge in it. IPs of one colo share the same cache, so extra
+// probes there add nothing; the unused IPs are kept as standbys and take over
+// when a representative fails. Within a colo, IPs are used in the order of
+// records (the tracker orders them by RTT). IPs without a known colo are
+// always probed.
+class ColoSelector {
+public:
+    ColoSelector(const std::vector<AliveRecord>& records, size_t per_colo);
+
+    // First round: up to per_colo IPs of every colo plus every IP without one
+    IPRangeList representatives();
+
+    // One standby for every representative whose probes in results[first, end)
+    // errored, from the same colo while it has any left
+    IPRangeList failover(const ResultStore& results, size_t first);
+
+    size_t coloCount() const { return colos_.size(); }
+
+    // IPs not probed in the first round
+    size_t standbyCount() const { return standbys_; }
+
+private:
+    struct Colo {
+        std::vector<uint32_t> ips;  // In record order
+        size_t next = 0;            // First IP not handed out yet
+    };
+
+    size_t per_colo_;
+    size_t standbys_;
+    std::vector<Colo> colos_;
+    std::unordered_map<uint32_t, size_t> colo_of_;  // IP -> index in colos_
+    std::vector<uint32_t> unknown_;                 // IPs without a colo
+};
+
+} // namespace cfpinner
+
+#endif // COLO_SELECTOR_H
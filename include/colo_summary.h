@@ -0,0 +1,50 @@
+#ifndef COLO_SUMMARY_H
+#define COLO_SUMMARY_H
+
+#include "result_store.h"
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace cfpinner {
+
+// Results aggregated per colo, for scans too large to list IP by IP.
+// Colos are found through a direct-indexed table over the 26^3 IATA codes
+// (ResultStore::encodeIATA), so adding a result is one array lookup and the
+// memory used only grows with the number of distinct colos seen. Results
+// without a colo (errors, missing CF-Ray) are grouped under code 0.
+class ColoSummary {
+public:
+    struct Colo {
+        uint16_t iata = 0;
+        uint16_t country = 0;           // First country seen at the colo
+        size_t hits = 0;
+        size_t misses = 0;              // Answered but not HIT
+        size_t errors = 0;
+        uint64_t connect_us_sum = 0;    // Over probes with a measured connect time
+        size_t connect_samples = 0;
+        uint32_t min_connect_us = 0;
+
+        size_t total() const { return hits + misses + errors; }
+        double meanConnectMs() const { return connect_samples ? connect_us_sum / 1000.0 / connect_samples : 0.0; }
+    };
+
+    ColoSummary();
+
+    // Add one result; fallback_iata is used when the result has no colo
+    // (e.g. an error at an IP whose colo is known from the alive cache)
+    void add(const ResultStore& results, size_t index, uint16_t fallback_iata = 0);
+
+    size_t size() const { return colos_.size(); }
+
+    // Colos with the most hits first, then the most probes
+    std::vector<Colo> sorted() const;
+
+private:
+    std::vector<uint16_t> slots_;  // IATA code -> position in colos_ + 1, 0 = not seen
+    std::vector<Colo> colos_;
+};
+
+} // namespace cfpinner
+
+#endif // COLO_SUMMARY_H
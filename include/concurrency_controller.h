@@ -0,0 +1,73 @@
+#ifndef CONCURRENCY_CONTROLLER_H
+#define CONCURRENCY_CONTROLLER_H
+
+#include <atomic>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace cfpinner {
+
+// AIMD controller for the number of probes kept in flight.
+// Completed probes are grouped into windows of roughly one limit's worth.
+// At the end of each window the controller compares the congestion error rate
+// (timeouts, resets, failed connects) and the median latency with a baseline:
+// while both stay flat the limit grows (doubling until the first backoff,
+// then additively), and when either degrades it is cut multiplicatively.
+// If a few backoffs in a row do not improve the signal, the errors come from
+// the targets rather than from us: the baseline is moved and the limit restored.
+// Driven from the probe engine's event loop; limit() and describe() may be
+// read from other threads.
+class ConcurrencyController {
+public:
+    ConcurrencyController(size_t min_limit, size_t max_limit, size_t initial_limit = 64);
+
+    // Current in-flight limit
+    size_t limit() const { return limit_.load(std::memory_order_relaxed); }
+
+    // Record a finished probe. congested marks failures that can be caused
+    // by too much load; latency_us is only used for successful probes.
+    void record(bool success, bool congested, long latency_us);
+
+    // Short description of the last decision for progress output, e.g. "512 ramp"
+    std::string describe() const;
+
+    // The last decision ("ramp", "grow", "backoff", ...); a string literal
+    const char* lastAction() const { return last_action_.load(std::memory_order_relaxed); }
+
+    size_t peakLimit() const { return peak_limit_; }
+    size_t backoffs() const { return backoffs_; }
+
+private:
+    enum Phase { SLOW_START, STEADY, PROBING_BACKOFF };
+
+    size_t min_limit_;
+    size_t max_limit_;
+    std::atomic<size_t> limit_;
+    size_t peak_limit_;
+    size_t backoffs_;
+    Phase phase_;
+    std::atomic<const char*> last_action_;
+
+    // Current window
+    size_t window_count_;
+    size_t window_congested_;
+    std::vector<long> window_latency_us_;
+
+    // Baselines from healthy windows; negative until the first window closes
+    double baseline_error_rate_;
+    long baseline_latency_us_;
+
+    // Window signals that triggered the last backoff, and the limit before it
+    double backoff_error_rate_;
+    long backoff_latency_us_;
+    size_t limit_before_backoff_;
+    size_t backoff_streak_;   // Consecutive backoffs that did not help yet
+
+    void closeWindow();
+    void setLimit(size_t limit);
+};
+
+} // namespace cfpinner
+
+#endif // CONCURRENCY_CONTROLLER_H
@@ -0,0 +1,61 @@
+#ifndef CONNECT_SCANNER_H
+#define CONNECT_SCANNER_H
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include "ip_range_list.h"
+
+namespace cfpinner {
+
+// Called once per target (IPv4 in host byte order) with whether the TCP connect succeeded
+using ConnectCallback = std::function<void(uint32_t ip, bool is_open)>;
+
+// Connect-only liveness scanner.
+// Issues non-blocking TCP connects from a single epoll loop and reports which
+// targets accepted the connection. Nothing is sent over the socket, so a probe
+// costs one SYN round trip instead of TCP + TLS + HTTP.
+class ConnectScanner {
+public:
+    explicit ConnectScanner(size_t max_in_flight = 20000);
+    ~ConnectScanner();
+
+    ConnectScanner(const ConnectScanner&) = delete;
+    ConnectScanner& operator=(const ConnectScanner&) = delete;
+
+    // Set how long to wait for a connect to complete (in milliseconds)
+    void setTimeoutMs(int timeout_ms);
+
+    // Set the TCP port to connect to (default: 443)
+    void setPort(uint16_t port);
+
+    // Set the maximum number of half-open connects kept in flight
+    void setMaxInFlight(size_t max_in_flight);
+
+    // Stop starting new connects once *stop becomes true (e.g. set by a
+    // signal handler); connects in flight still complete (nullptr disables)
+    void setStopFlag(const std::atomic<bool>* stop);
+
+    // Connect to every IP and report the outcome through on_result
+    void scan(const IPRangeList& ips, const ConnectCallback& on_result);
+
+private:
+    struct Slot {
+        int fd;
+        uint32_t ip;          // Target being connected to
+        uint32_t generation;  // Bumped on reuse so stale timeouts can be skipped
+    };
+
+    int epoll_fd_;
+    int timeout_ms_;
+    uint16_t port_;
+    size_t max_in_flight_;
+    const std::atomic<bool>* stop_;
+};
+
+} // namespace cfpinner
+
+#endif // CONNECT_SCANNER_H
@@ -0,0 +1,122 @@
+#ifndef DASHBOARD_H
+#define DASHBOARD_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <streambuf>
+#include <ostream>
+#include <cstdint>
+#include <cstddef>
+
+namespace cfpinner {
+
+struct ResultEvent;
+struct TrackJob;
+
+// Full-screen ncurses view of a running scan: a scrollable list of every
+// result, per-colo counters and throughput, redrawn by its own thread at a
+// fixed frame rate.
+//
+// The result consumer thread feeds it with add(), which only appends to
+// chunked, append-only storage and bumps counters (no locks, no terminal
+// I/O); the render thread reads whatever has been published so far and
+// draws only the rows that fit on screen, so a million results cost no more
+// per frame than a hundred. While the dashboard is up, std::cout is captured
+// (the latest line is shown in the status bar) and replayed after it closes.
+class Dashboard {
+public:
+    explicit Dashboard(unsigned frames_per_second = 10);
+    ~Dashboard();
+
+    Dashboard(const Dashboard&) = delete;
+    Dashboard& operator=(const Dashboard&) = delete;
+
+    // Whether the binary has ncurses support and stdout is a terminal
+    static bool available();
+
+    // Take over the terminal for a scan of expected_results probes;
+    // url_index of later results refers to jobs
+    void begin(const std::vector<TrackJob>& jobs, size_t expected_results, const std::string& title);
+
+    // More probes were scheduled (e.g. failover rounds)
+    void addExpected(size_t count);
+
+    // Record one result; consumer thread only
+    void add(const ResultEvent& event);
+
+    // Mark the scan complete, wait for the user to press q, then restore the
+    // terminal and print what was written to std::cout meanwhile
+    void end();
+
+    bool active() const { return active_; }
+
+private:
+    struct Row {
+        uint32_t ip;
+        uint32_t connect_time_us;
+        uint16_t url_index;
+        uint16_t iata;
+        uint16_t country;
+        uint16_t status_code;
+        uint8_t cache_status;  // CacheStatus
+        uint8_t error;         // ErrorClass
+    };
+
+    static const size_t CHUNK_ROWS = 1 << 14;
+    static const size_t MAX_CHUNKS = 1 << 10;  // 16M rows; later results are only counted
+
+    struct ColoCounters {
+        std::atomic<uint32_t> hits{0};
+        std::atomic<uint32_t> misses{0};
+        std::atomic<uint32_t> errors{0};
+    };
+
+    // Collects std::cout output from any thread while the screen is in use
+    class CaptureBuffer : public std::streambuf {
+    public:
+        std::string text() const;
+        std::string lastLine() const;
+
+    protected:
+        int overflow(int c) override;
+        std::streamsize xsputn(const char* data, std::streamsize count) override;
+
+    private:
+        mutable std::mutex mutex_;
+        std::string text_;
+    };
+
+    unsigned frame_ms_;
+    bool active_;
+    std::string title_;
+    std::vector<std::string> labels_;  // Per url_index
+
+    // Results: written by add(), read by the render thread
+    std::unique_ptr<std::atomic<Row*>[]> chunks_;
+    std::atomic<size_t> row_count_;
+    std::atomic<size_t> result_count_;  // Including results beyond the row limit
+    std::atomic<size_t> expected_;
+    std::atomic<size_t> hits_;
+    std::atomic<size_t> misses_;
+    std::atomic<size_t> errors_;
+    std::unique_ptr<ColoCounters[]> colos_;  // Indexed by IATA code
+    std::unique_ptr<uint16_t[]> seen_colos_;
+    std::atomic<size_t> seen_colo_count_;
+
+    std::atomic<bool> scan_done_;
+    std::atomic<bool> quit_;           // Stop rendering
+    std::thread render_thread_;
+    CaptureBuffer capture_;
+    std::streambuf* saved_cout_;
+
+    void renderLoop();
+    const Row& row(size_t index) const;
+};
+
+} // namespace cfpinner
+
+#endif // DASHBOARD_H
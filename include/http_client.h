@@ -3,6 +3,10 @@
 
 #include <string>
 #include <functional>
+#include <memory>
+#include <mutex>
+#include <curl/curl.h>
+#include "cf_header_parser.h"
 
 namespace cfpinner {
 
@@ -16,6 +20,33 @@ struct HTTPResponse {
     std::string cf_ray;
     std::string cf_iata_code;
     std::string cf_ip_country;
+    long connect_time_us = 0;  // Time until the TCP connection was established
+    long tls_time_us = 0;      // Time until the TLS handshake was done (0 if reused)
+    long ttfb_us = 0;          // Time until the first response byte
+    long total_time_us = 0;    // Time until the response was complete
+    int curl_code = 0;         // CURLcode of the transfer (CURLE_OK on success)
+};
+
+// DNS and TLS session cache shared between clients (connections are not
+// shared: each handle or multi handle keeps its own).
+// Workers attached to the same share resume TLS sessions with edges that any
+// of them has already talked to instead of doing a full handshake.
+class CurlShare {
+public:
+    CurlShare();
+    ~CurlShare();
+
+    CurlShare(const CurlShare&) = delete;
+    CurlShare& operator=(const CurlShare&) = delete;
+
+    CURLSH* handle() const;
+
+private:
+    CURLSH* share_;
+    std::mutex locks_[CURL_LOCK_DATA_LAST];
+
+    static void lockCallback(CURL* handle, curl_lock_data data, curl_lock_access access, void* userptr);
+    static void unlockCallback(CURL* handle, curl_lock_data data, void* userptr);
 };
 
 class HTTPClient {
@@ -23,18 +54,48 @@ public:
     HTTPClient();
     ~HTTPClient();
 
-    // Make a HEAD request to check if image exists
-    HTTPResponse head(const std::string& url, const std::string& host_header = "");
+    HTTPClient(const HTTPClient&) = delete;
+    HTTPClient& operator=(const HTTPClient&) = delete;
+
+    // Initialize libcurl once per process (safe to call from any thread)
+    static void globalInit();
+
+    // Whether a failed transfer may succeed when simply tried again later
+    // (timeouts, resets, empty replies) rather than being a definite answer
+    static bool isTransientError(int curl_code);
+
+    // Make a HEAD request to check if image exists.
+    // The underlying easy handle is kept open and reused between requests.
+    // connect_to is an optional CURLOPT_CONNECT_TO entry ("host:port:ip:port")
+    // that pins the connection to a given edge while keeping the URL's hostname.
+    HTTPResponse head(const std::string& url, const std::string& host_header = "",
+                      const char* connect_to = nullptr);
+
+    // Attach a share so DNS and TLS sessions are reused across clients
+    void setShare(std::shared_ptr<CurlShare> share);
 
     // Set timeout for requests (in seconds)
     void setTimeout(int timeout_seconds);
 
+    // Set connect and total timeouts in milliseconds (connect 0 = bounded by total only)
+    void setTimeoutMs(long connect_timeout_ms, long timeout_ms);
+
     // Set custom User-Agent
     void setUserAgent(const std::string& user_agent);
 
 private:
-    int timeout_seconds_;
+    long connect_timeout_ms_;
+    long timeout_ms_;
     std::string user_agent_;
+    CURL* curl_;                      // Reused easy handle, created on first request
+    std::shared_ptr<CurlShare> share_;
+    struct curl_slist* host_list_;    // Cached Host header for host_list_value_
+    std::string host_list_value_;
+    struct curl_slist connect_to_node_; // Points at the caller's connect_to entry
+    bool connect_to_set_;
+    CFHeaderParser header_parser_;
+
+    bool ensureHandle();
 };
 
 } // namespace cfpinner
@@ -0,0 +1,82 @@
+#ifndef IP_RANGE_LIST_H
+#define IP_RANGE_LIST_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace cfpinner {
+
+// Scan targets as a list of CIDR ranges that are never expanded.
+// Addresses are computed on demand, either by index (at) or in order (Cursor),
+// so memory stays proportional to the number of ranges however many addresses
+// they cover. Sampling of large ranges and skipping of network/broadcast
+// addresses follow the rules of CIDRUtils::expandCIDR.
+class IPRangeList {
+public:
+    // Add a CIDR range (or a single address); at most max_ips addresses are
+    // sampled from it, SIZE_MAX takes every host. Returns false if unparsable.
+    bool addRange(const std::string& cidr, size_t max_ips = SIZE_MAX);
+
+    // Add one address (host byte order)
+    void addAddress(uint32_t ip);
+
+    // Total number of target addresses
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    // Address at index (host byte order); O(log ranges)
+    uint32_t at(size_t index) const;
+
+    // Address at index as a dotted string
+    std::string addressAt(size_t index) const;
+
+    // The addresses of shard index out of count. Each address goes to the
+    // shard picked by a hash of the address itself, so shards are disjoint,
+    // identical on every host whatever the order of the ranges, and get an
+    // even share of every range. The result holds its addresses explicitly.
+    IPRangeList shard(size_t index, size_t count) const;
+
+    // Shard of ip out of count, as used by shard()
+    static size_t shardOf(uint32_t ip, size_t count);
+
+    // Forward iteration without the binary search
+    class Cursor {
+    public:
+        explicit Cursor(const IPRangeList& list) : list_(list) {}
+
+        // Next address; returns false when the list is exhausted
+        bool next(uint32_t& ip);
+
+    private:
+        const IPRangeList& list_;
+        size_t segment_ = 0;
+        uint32_t offset_ = 0;
+    };
+
+private:
+    // A run of target addresses
+    struct Segment {
+        enum Kind : uint8_t { HOSTS, SAMPLED, LIST };
+
+        Kind kind;
+        uint32_t base;         // HOSTS/SAMPLED: network address; LIST: index into addresses_
+        uint32_t first;        // HOSTS: first host offset (skips the network address)
+        uint32_t total_hosts;  // SAMPLED: addresses in the range
+        uint32_t step;         // SAMPLED: distance between samples
+        uint32_t count;        // Targets in this segment
+        size_t start;          // Index of the segment's first target in the whole list
+    };
+
+    std::vector<Segment> segments_;
+    std::vector<uint32_t> addresses_;  // Backing store for LIST segments
+    size_t size_ = 0;
+
+    uint32_t addressIn(const Segment& segment, uint32_t offset) const;
+    void push(Segment segment);
+};
+
+} // namespace cfpinner
+
+#endif // IP_RANGE_LIST_H
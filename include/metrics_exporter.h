@@ -0,0 +1,61 @@
+#ifndef METRICS_EXPORTER_H
+#define METRICS_EXPORTER_H
+
+#include "scan_metrics.h"
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+namespace cfpinner {
+
+// Writes ScanMetrics snapshots from a background thread every interval and
+// once more when stopped: <directory>/cfpinner.prom in the Prometheus text
+// format (for the node exporter's textfile collector) and
+// <directory>/cfpinner.json. Both are written to a temporary file and
+// renamed, so collectors never read a partial file.
+class MetricsExporter {
+public:
+    // scan labels the metrics (e.g. "alive" or "track")
+    MetricsExporter(const ScanMetrics& metrics, const std::string& directory,
+                    const std::string& scan, unsigned interval_s = 15);
+    ~MetricsExporter();
+
+    MetricsExporter(const MetricsExporter&) = delete;
+    MetricsExporter& operator=(const MetricsExporter&) = delete;
+
+    void start();
+
+    // Stop the thread and write the final snapshot
+    void stop();
+
+    std::string prometheusPath() const { return directory_ + "/cfpinner.prom"; }
+    std::string jsonPath() const { return directory_ + "/cfpinner.json"; }
+
+    // Write one snapshot now; rate is the recent probes per second
+    bool write(const ScanMetrics::Snapshot& snapshot, double rate) const;
+
+private:
+    std::string formatPrometheus(const ScanMetrics::Snapshot& snapshot, double rate) const;
+    std::string formatJSON(const ScanMetrics::Snapshot& snapshot, double rate) const;
+
+    // Snapshot, rate since the previous export, write
+    void exportNow();
+
+    const ScanMetrics& metrics_;
+    std::string directory_;
+    std::string scan_;
+    unsigned interval_s_;
+
+    std::thread thread_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    bool running_;
+
+    uint64_t last_completed_;
+    double last_uptime_s_;
+};
+
+} // namespace cfpinner
+
+#endif // METRICS_EXPORTER_H
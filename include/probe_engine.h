@@ -0,0 +1,136 @@
+#ifndef PROBE_ENGINE_H
+#define PROBE_ENGINE_H
+
+#include <string>
+#include <deque>
+#include <vector>
+#include <functional>
+#include <memory>
+#include <cstddef>
+#include <curl/curl.h>
+#include "http_client.h"
+#include "concurrency_controller.h"
+
+namespace cfpinner {
+
+// What to request from every edge; built once per scan and shared by all probes
+struct ProbeTarget {
+    std::string url;          // Original URL, e.g. "https://example.com/img.png"
+    std::string url_host;     // Host part of the URL
+    std::string host;         // Host header / SNI name to present to the edge
+    std::string host_line;    // Prebuilt "Host: <host>" header line
+    std::string scheme;       // "https" or "http"
+    std::string path;         // Path and query, e.g. "/img.png"
+    int port = 443;           // Port the edge is contacted on
+    bool pin_connect = false; // Keep the URL and route to the edge with CURLOPT_CONNECT_TO
+
+    // Parse a URL (scheme defaults to https); host_override replaces the Host header
+    static ProbeTarget fromURL(const std::string& url, bool pin_connect, const std::string& host_override = "");
+
+    // URL with the host replaced by the edge IP (used when not pinning)
+    std::string urlForIP(const std::string& ip_address) const;
+
+    // Whether a Host header has to be sent explicitly
+    bool needsHostHeader() const { return !pin_connect || host != url_host; }
+
+    // CURLOPT_CONNECT_TO entry "host:port:ip:port" routing to ip_address
+    std::string connectTo(const std::string& ip_address) const;
+};
+
+// A single HEAD probe against one edge IP
+struct ProbeRequest {
+    std::string ip_address;               // Edge IP being probed
+    const ProbeTarget* target = nullptr;  // Must outlive the probe
+    size_t url_index = 0;                 // Which of the caller's targets this probe checks
+    long connect_timeout_ms = -1;         // Per-probe deadlines, -1 uses the engine defaults
+    long timeout_ms = -1;
+    unsigned attempt = 0;                 // Retries already made for this probe
+};
+
+// Produces the next probe to run; returns false when there is no more work
+using ProbeSource = std::function<bool(ProbeRequest& request)>;
+
+// Called once for every finished probe
+using ProbeCallback = std::function<void(const ProbeRequest& request, const HTTPResponse& response)>;
+
+// Event-driven probe engine built on curl_multi and epoll.
+// A single thread drives up to max_in_flight concurrent HEAD requests,
+// pulling new work only when a slot frees up.
+class ProbeEngine {
+public:
+    explicit ProbeEngine(size_t max_in_flight = 1000);
+    ~ProbeEngine();
+
+    ProbeEngine(const ProbeEngine&) = delete;
+    ProbeEngine& operator=(const ProbeEngine&) = delete;
+
+    // Set timeout for each probe (in seconds)
+    void setTimeout(int timeout_seconds);
+
+    // Set default connect and total timeouts in milliseconds (connect 0 = bounded by total only)
+    void setTimeoutMs(long connect_timeout_ms, long timeout_ms);
+
+    // Set custom User-Agent
+    void setUserAgent(const std::string& user_agent);
+
+    // Share DNS and TLS sessions with other clients
+    void setShare(std::shared_ptr<CurlShare> share);
+
+    // Open at most one HTTP/2 connection per edge and multiplex every probe
+    // for that edge over it as concurrent streams
+    void setMultiplex(bool enabled);
+
+    // Set the maximum number of probes kept in flight
+    void setMaxInFlight(size_t max_in_flight);
+    size_t getMaxInFlight() const;
+
+    // Let controller pick the in-flight limit (capped by max_in_flight) and
+    // feed it every finished probe; nullptr keeps the fixed limit.
+    // The controller must outlive run().
+    void setConcurrencyController(ConcurrencyController* controller);
+
+    // Queue a probe; queued probes are started before the source is consulted
+    void submit(ProbeRequest request);
+
+    // Run the event loop until the queue and the source are exhausted
+    // and every in-flight probe has completed
+    void run(const ProbeSource& source, const ProbeCallback& on_complete);
+
+    // Run until every submitted probe has completed
+    void run(const ProbeCallback& on_complete);
+
+    // Number of probes currently in flight
+    size_t inFlight() const;
+
+    // Raise the soft open-file limit to the hard limit and return it.
+    // Each in-flight probe holds one socket, so the default 1024 is far too low.
+    static size_t raiseFileLimit();
+
+private:
+    struct Transfer;
+
+    CURLM* multi_;
+    int epoll_fd_;
+    long long timer_deadline_ms_; // When curl wants to be driven next, -1 when none
+    size_t max_in_flight_;
+    size_t in_flight_;
+    ConcurrencyController* controller_;
+    bool multiplex_;
+    long connect_timeout_ms_;
+    long timeout_ms_;
+    std::string user_agent_;
+    std::shared_ptr<CurlShare> share_;
+    std::deque<ProbeRequest> queue_;
+    std::vector<CURL*> idle_handles_; // Easy handles kept for reuse
+
+    bool startTransfer(ProbeRequest& request);
+    void driveTimeouts(const ProbeCallback& on_complete);
+    void finishTransfers(const ProbeCallback& on_complete);
+
+    static int socketCallback(CURL* easy, curl_socket_t fd, int what, void* userp, void* socketp);
+    static int timerCallback(CURLM* multi, long timeout_ms, void* userp);
+};
+
+} // namespace cfpinner
+
+#endif // PROBE_ENGINE_H
@@ -0,0 +1,51 @@
+#ifndef RADIX_SORT_H
+#define RADIX_SORT_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace cfpinner {
+
+// Stable LSD radix sort of records by a 32-bit key (e.g. an IPv4 address),
+// in at most four 8-bit passes over a scratch buffer of the same size.
+// Passes where every key has the same byte are skipped, so addresses from a
+// few /16s cost two passes. key must be a cheap function of the record.
+template <typename T, typename KeyFn>
+void radixSort(std::vector<T>& records, KeyFn key) {
+    if (records.size() < 2) {
+        return;
+    }
+
+    // Histograms of all four bytes in one read of the input
+    size_t counts[4][256] = {};
+    for (const T& record : records) {
+        uint32_t value = key(record);
+        for (int pass = 0; pass < 4; pass++) {
+            counts[pass][(value >> (pass * 8)) & 0xff]++;
+        }
+    }
+
+    std::vector<T> scratch(records.size());
+    for (int pass = 0; pass < 4; pass++) {
+        uint32_t shift = static_cast<uint32_t>(pass * 8);
+        if (counts[pass][(key(records[0]) >> shift) & 0xff] == records.size()) {
+            continue;
+        }
+
+        size_t offsets[256];
+        size_t total = 0;
+        for (int digit = 0; digit < 256; digit++) {
+            offsets[digit] = total;
+            total += counts[pass][digit];
+        }
+        for (const T& record : records) {
+            scratch[offsets[(key(record) >> shift) & 0xff]++] = record;
+        }
+        records.swap(scratch);
+    }
+}
+
+} // namespace cfpinner
+
+#endif // RADIX_SORT_H
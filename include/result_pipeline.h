@@ -0,0 +1,67 @@
+#ifndef RESULT_PIPELINE_H
+#define RESULT_PIPELINE_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <thread>
+#include "cf_header_parser.h"
+#include "mpsc_ring.h"
+
+namespace cfpinner {
+
+struct HTTPResponse;
+struct ProbeRequest;
+
+// Compact, fixed-size record of one finished probe
+struct ResultEvent {
+    uint32_t ip;            // Edge IPv4 address in host byte order
+    uint16_t url_index;     // Which target URL was probed
+    uint16_t status_code;
+    int32_t curl_code;      // CURLcode, CURLE_OK on success
+    uint32_t connect_time_us; // TCP connect time, 0 if unknown or reused
+    bool success;
+    bool is_hit;
+    CFHeaders headers;
+
+    static ResultEvent fromProbe(const ProbeRequest& request, const HTTPResponse& response);
+
+    // Human-readable error for failed probes
+    const char* errorMessage() const;
+};
+
+// Moves probe results from the workers to one consumer thread.
+// Workers publish ResultEvents into a bounded MPSC ring and never touch the
+// console or shared containers; the consumer thread runs the handler for
+// every event, so rendering, aggregation and file output need no locks.
+// on_idle runs whenever the ring has been drained (e.g. to flush output).
+class ResultPipeline {
+public:
+    using Handler = std::function<void(const ResultEvent& event)>;
+    using IdleHandler = std::function<void()>;
+
+    explicit ResultPipeline(Handler handler, IdleHandler on_idle = IdleHandler(), size_t capacity = 8192);
+    ~ResultPipeline();
+
+    ResultPipeline(const ResultPipeline&) = delete;
+    ResultPipeline& operator=(const ResultPipeline&) = delete;
+
+    // Called from any worker thread; only waits if the ring is full
+    void publish(const ResultEvent& event);
+
+    // Handle every published event and stop the consumer thread
+    void finish();
+
+private:
+    MPSCRing<ResultEvent> ring_;
+    Handler handler_;
+    IdleHandler on_idle_;
+    std::atomic<bool> done_;
+    std::thread consumer_;
+
+    void consume();
+};
+
+} // namespace cfpinner
+
+#endif // RESULT_PIPELINE_H
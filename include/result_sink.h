@@ -0,0 +1,95 @@
+#ifndef RESULT_SINK_H
+#define RESULT_SINK_H
+
+#include "buffered_writer.h"
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+namespace cfpinner {
+
+struct ResultEvent;
+struct TrackJob;
+
+// One result in the binary output format, after the header and URL table
+struct ResultRecord {
+    uint32_t ip;               // IPv4 in host byte order
+    uint32_t timestamp;        // Unix time the result arrived
+    uint64_t ray;              // ResultStore::encodeRay
+    uint32_t connect_time_us;
+    uint16_t url_index;        // Into the URL table
+    uint16_t status_code;
+    uint16_t iata;             // ResultStore::encodeIATA
+    uint16_t country;          // ResultStore::encodeCountry
+    uint8_t cache_status;      // CacheStatus
+    uint8_t error;             // ErrorClass
+    uint16_t curl_code;        // CURLcode, 0 on success
+};
+static_assert(sizeof(ResultRecord) == 32, "ResultRecord is part of the file format");
+
+// Streams probe results to a file as they arrive, in a machine-readable
+// format. Records go through a BufferedWriter, so memory stays constant and
+// nothing is flushed per line; readers of a file or pipe see whole buffers
+// while the scan runs and everything once the sink is closed.
+// Used from the result consumer thread only.
+//
+// Formats:
+//   ndjson  One JSON object per line
+//   csv     A header row, then one row per result
+//   binary  "CFPRSLT1" header, URL table, then fixed 32-byte ResultRecords
+class ResultSink {
+public:
+    enum class Format { NDJSON, CSV, BINARY };
+
+    virtual ~ResultSink();
+
+    // "ndjson" (or "json", "jsonl"), "csv" or "binary" (or "bin")
+    static bool parseFormat(const std::string& name, Format& format);
+
+    // Format implied by a file extension, NDJSON if unknown
+    static Format formatForPath(const std::string& path);
+
+    // Create a sink writing to path ("-" for stdout); nullptr on error
+    static std::unique_ptr<ResultSink> open(Format format, const std::string& path);
+
+    // Whether path starts with the binary format's header
+    static bool isBinaryFile(const std::string& path);
+
+    // Load a binary result file: its URL table into jobs, its records
+    // appended to records
+    static bool readBinary(const std::string& path, std::vector<TrackJob>& jobs, std::vector<ResultRecord>& records);
+
+    // Write records (whose url_index refers to jobs) as a binary result file
+    static bool writeBinary(const std::string& path, const std::vector<TrackJob>& jobs,
+                            const std::vector<ResultRecord>& records);
+
+    // The jobs url_index refers to; only the first call counts
+    void begin(const std::vector<TrackJob>& jobs);
+
+    virtual void write(const ResultEvent& event) = 0;
+
+    // Hand buffered results to the kernel (e.g. between watch rounds)
+    bool flush() { return out_.flush(); }
+
+    // Flush and close; false if any write failed
+    bool close() { return out_.close(); }
+
+    size_t count() const { return count_; }
+    const std::string& path() const { return path_; }
+
+protected:
+    ResultSink();
+
+    // Write the format's header for jobs
+    virtual void start(const std::vector<TrackJob>& jobs) = 0;
+
+    BufferedWriter out_;
+    std::string path_;
+    size_t count_;
+    bool started_;
+};
+
+} // namespace cfpinner
+
+#endif // RESULT_SINK_H
@@ -0,0 +1,116 @@
+#ifndef RESULT_STORE_H
+#define RESULT_STORE_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace cfpinner {
+
+struct ResultEvent;
+
+// CF-Cache-Status values
+enum class CacheStatus : uint8_t {
+    NONE,        // Header missing
+    HIT,
+    MISS,
+    EXPIRED,
+    STALE,
+    BYPASS,
+    REVALIDATED,
+    UPDATING,
+    DYNAMIC,
+    UNKNOWN      // Any other value
+};
+
+// Why a probe failed, reduced from its CURLcode
+enum class ErrorClass : uint8_t {
+    NONE,
+    TIMEOUT,
+    CONNECT,     // Refused or unreachable
+    RESOLVE,
+    TLS,
+    RESET,       // Send/receive error, empty or partial reply
+    OTHER
+};
+
+// Probe results of a scan stored column by column.
+// Each column is a contiguous array indexed by result number; strings are
+// reduced to fixed-width codes: the IP as a uint32_t, cache status and error
+// as one-byte enums, the IATA colo as its index in the 26^3 three-letter
+// space, the country as two packed characters and the CF-Ray ID as its
+// 8 binary bytes (its "-XXX" suffix is the IATA column). A result takes
+// 26 bytes, and counting or filtering only touches the columns it needs.
+class ResultStore {
+public:
+    void reserve(size_t count);
+    void clear();
+
+    // Append one finished probe
+    void add(const ResultEvent& event);
+
+    size_t size() const { return ips_.size(); }
+    bool empty() const { return ips_.empty(); }
+
+    // Columns
+    uint32_t ip(size_t index) const { return ips_[index]; }
+    uint16_t urlIndex(size_t index) const { return url_indices_[index]; }
+    uint16_t statusCode(size_t index) const { return status_codes_[index]; }
+    CacheStatus cacheStatus(size_t index) const { return cache_statuses_[index]; }
+    ErrorClass error(size_t index) const { return errors_[index]; }
+    uint16_t iata(size_t index) const { return iatas_[index]; }
+    uint16_t country(size_t index) const { return countries_[index]; }
+    uint64_t ray(size_t index) const { return rays_[index]; }
+    uint32_t connectTimeUs(size_t index) const { return connect_times_us_[index]; }
+
+    bool isError(size_t index) const { return errors_[index] != ErrorClass::NONE; }
+    bool isHit(size_t index) const { return cache_statuses_[index] == CacheStatus::HIT; }
+
+    // Decoded values for display ("" when absent)
+    std::string ipString(size_t index) const;
+    std::string iataString(size_t index) const { return decodeIATA(iatas_[index]); }
+    std::string countryString(size_t index) const { return decodeCountry(countries_[index]); }
+    std::string rayString(size_t index) const;
+
+    // HIT/MISS/ERROR counts, for one URL or (url_index < 0) all of them
+    struct Counts {
+        size_t total = 0;
+        size_t hits = 0;
+        size_t misses = 0;
+        size_t errors = 0;
+    };
+    Counts count(int url_index = -1) const;
+
+    // Code conversions
+    static CacheStatus parseCacheStatus(const char* value);
+    static const char* cacheStatusName(CacheStatus status);
+    static ErrorClass classifyError(int curl_code);
+    static const char* errorClassName(ErrorClass error);
+
+    // Three letters -> 1..17576, anything else -> 0
+    static uint16_t encodeIATA(const char* code);
+    static std::string decodeIATA(uint16_t code);
+
+    // Two characters packed high byte first, 0 = none
+    static uint16_t encodeCountry(const char* code);
+    static std::string decodeCountry(uint16_t code);
+
+    // Hex ray ID before the dash -> 8 bytes, 0 = none or unparsable
+    static uint64_t encodeRay(const char* ray);
+
+private:
+    std::vector<uint32_t> ips_;
+    std::vector<uint16_t> url_indices_;
+    std::vector<uint16_t> status_codes_;
+    std::vector<CacheStatus> cache_statuses_;
+    std::vector<ErrorClass> errors_;
+    std::vector<uint16_t> iatas_;
+    std::vector<uint16_t> countries_;
+    std::vector<uint64_t> rays_;
+    std::vector<uint32_t> connect_times_us_;
+};
+
+} // namespace cfpinner
+
+#endif // RESULT_STORE_H
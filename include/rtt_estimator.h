@@ -0,0 +1,61 @@
+#ifndef RTT_ESTIMATOR_H
+#define RTT_ESTIMATOR_H
+
+#include <cstdint>
+#include <cstddef>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace cfpinner {
+
+// Online estimate of edge round-trip times used to size per-probe deadlines.
+// Connect and total times of successful probes are kept per address block
+// (/16); once a block has enough samples its probes get a deadline of
+// multiplier x p99, clamped to [floor, ceiling]. Blocks without enough data
+// fall back to the global estimate, and to the ceiling before that.
+// Thread-safe.
+class RTTEstimator {
+public:
+    RTTEstimator(double multiplier = 4.0, long floor_ms = 50, long ceiling_ms = 5000);
+
+    // Set the hard upper bound for both deadlines (in milliseconds)
+    void setCeilingMs(long ceiling_ms);
+
+    // Block key for an IPv4 address in host byte order
+    static uint32_t blockOf(uint32_t ip) { return ip >> 16; }
+
+    // Record a successful probe's connect and total time (in microseconds)
+    void record(uint32_t block, long connect_us, long total_us);
+
+    // Connect and total deadlines for the next probe in block (in milliseconds)
+    void deadlines(uint32_t block, long& connect_ms, long& total_ms) const;
+
+private:
+    // Sliding window of the most recent samples for one block
+    struct Window {
+        std::vector<long> connect_us;
+        std::vector<long> total_us;
+        size_t next = 0;          // Slot the next sample overwrites once full
+        size_t since_update = 0;  // Samples since the p99 values were refreshed
+        long connect_p99_us = 0;
+        long total_p99_us = 0;
+    };
+
+    static const size_t kWindowSize = 64;
+    static const size_t kMinSamples = 8;
+
+    double multiplier_;
+    long floor_ms_;
+    long ceiling_ms_;
+    mutable std::mutex mutex_;
+    std::unordered_map<uint32_t, Window> blocks_;
+    Window global_;
+
+    static void add(Window& window, long connect_us, long total_us);
+    long clampMs(long p99_us) const;
+};
+
+} // namespace cfpinner
+
+#endif // RTT_ESTIMATOR_H
@@ -0,0 +1,72 @@
+#ifndef SCAN_CHECKPOINT_H
+#define SCAN_CHECKPOINT_H
+
+#include "alive_index.h"
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace cfpinner {
+
+// Progress of an alive scan, kept on disk so that an interrupted scan can
+// continue where it stopped. Completion is a bitmap with one bit for every
+// address of the scanned CIDR ranges (about 190 KiB for Cloudflare's IPv4
+// space), so marking or testing an IP is a binary search over the ranges and
+// a bit operation, whatever sampling the scan uses. The alive records found
+// so far are kept alongside. Used from one thread only.
+//
+// File: a 56-byte header ("CFPCKPT1"), the bitmap as 64-bit words, then the
+// AliveRecords, in native byte order. Saved to a temporary file and renamed,
+// so a crash while saving leaves the previous checkpoint intact.
+class ScanCheckpoint {
+public:
+    static const uint32_t VERSION = 1;
+
+    ScanCheckpoint();
+
+    // Start empty over ranges (IPv6 ranges are ignored); scan_key identifies
+    // the scan settings, a checkpoint saved under another key is not loaded
+    void reset(const std::vector<std::string>& ranges, uint64_t scan_key);
+
+    // Replace the progress with a checkpoint of the same ranges and key;
+    // returns false if missing, damaged or written for another scan
+    bool load(const std::string& path);
+
+    bool save(const std::string& path) const;
+
+    // Record that ip was probed (addresses outside the ranges are ignored)
+    void markDone(uint32_t ip);
+    bool isDone(uint32_t ip) const;
+
+    // Number of addresses marked done
+    size_t completed() const { return completed_; }
+
+    void addRecord(const AliveRecord& record) { records_.push_back(record); }
+    const std::vector<AliveRecord>& records() const { return records_; }
+
+    // FNV-1a hash of the strings describing a scan, for scan_key
+    static uint64_t fingerprint(const std::vector<std::string>& parts);
+
+private:
+    // One CIDR range and where its bits start, sorted by base
+    struct Block {
+        uint32_t base;
+        uint64_t size;
+        uint64_t first_bit;
+    };
+
+    std::vector<Block> blocks_;
+    std::vector<uint64_t> bits_;
+    uint64_t bit_count_;
+    uint64_t key_;
+    size_t completed_;
+    std::vector<AliveRecord> records_;
+
+    // Bit of ip; false if ip is in none of the ranges
+    bool bitOf(uint32_t ip, uint64_t& bit) const;
+};
+
+} // namespace cfpinner
+
+#endif // SCAN_CHECKPOINT_H
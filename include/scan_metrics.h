@@ -0,0 +1,123 @@
+#ifndef SCAN_METRICS_H
+#define SCAN_METRICS_H
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace cfpinner {
+
+struct HTTPResponse;
+
+// Latency histogram with HDR-style log-linear buckets: every power of two
+// is split into 32 linear sub-buckets, so any recorded value is known to
+// within ~3%, from 1us up to ~134s (larger values are clamped). Recording
+// is one relaxed atomic increment.
+class LatencyHistogram {
+public:
+    static const int SUB_BUCKET_BITS = 5;
+    static const int MAX_VALUE_BITS = 27;
+    static const size_t BUCKETS = (MAX_VALUE_BITS - SUB_BUCKET_BITS + 1) << SUB_BUCKET_BITS;
+
+    LatencyHistogram();
+
+    void record(uint64_t value_us);
+
+    // Add the counts to a merged histogram of BUCKETS entries
+    void mergeInto(std::vector<uint64_t>& counts, uint64_t& sum, uint64_t& max) const;
+
+    static size_t bucketOf(uint64_t value_us);
+
+    // Midpoint of the values that fall into bucket
+    static uint64_t valueOf(size_t bucket);
+
+private:
+    std::atomic<uint64_t> counts_[BUCKETS];
+    std::atomic<uint64_t> sum_;
+    std::atomic<uint64_t> max_;
+};
+
+// Probe phases with a latency histogram
+enum class LatencyPhase : uint8_t {
+    CONNECT,   // TCP connect (new connections only)
+    TLS,       // TLS handshake after connect (new connections only)
+    TTFB,      // Request start to first response byte
+    TOTAL,
+    COUNT
+};
+
+// Live counters for a running scan.
+// Probe workers record into one of a fixed set of shards, picked per thread,
+// with relaxed atomic increments only; no locks are taken and threads mostly
+// write to their own cache lines. Readers merge every shard into a Snapshot,
+// which may be a few increments behind the workers but never blocks them.
+class ScanMetrics {
+public:
+    static const size_t CURL_CODES = 128;  // Errors by CURLcode (larger codes are folded into the last)
+    static const size_t CACHE_STATUSES = 10;
+
+    struct Latency {
+        std::vector<uint64_t> counts;  // LatencyHistogram::BUCKETS entries
+        uint64_t count = 0;
+        uint64_t sum_us = 0;
+        uint64_t max_us = 0;
+
+        // Value at quantile q (0..1) in microseconds, 0 without samples
+        uint64_t percentile(double q) const;
+    };
+
+    struct Snapshot {
+        double uptime_s = 0;
+        uint64_t started = 0;    // Probes handed to the transport (retries count again)
+        uint64_t completed = 0;
+        uint64_t succeeded = 0;
+        uint64_t retried = 0;    // Failures deferred to a retry round
+        uint64_t by_cache_status[CACHE_STATUSES] = {};  // Indexed by CacheStatus
+        uint64_t by_curl_code[CURL_CODES] = {};
+        Latency latency[static_cast<size_t>(LatencyPhase::COUNT)];
+
+        uint64_t inFlight() const { return started > completed ? started - completed : 0; }
+        uint64_t errors() const { return completed - succeeded; }
+    };
+
+    ScanMetrics();
+    ~ScanMetrics();
+
+    ScanMetrics(const ScanMetrics&) = delete;
+    ScanMetrics& operator=(const ScanMetrics&) = delete;
+
+    // Record from any thread
+    void probesStarted(size_t count);
+    void probeCompleted(const HTTPResponse& response);
+    void probeRetried();
+
+    Snapshot snapshot() const;
+
+private:
+    struct alignas(64) Shard {
+        std::atomic<uint64_t> started{0};
+        std::atomic<uint64_t> completed{0};
+        std::atomic<uint64_t> succeeded{0};
+        std::atomic<uint64_t> retried{0};
+        std::atomic<uint64_t> by_cache_status[CACHE_STATUSES];
+        std::atomic<uint64_t> by_curl_code[CURL_CODES];
+        LatencyHistogram latency[static_cast<size_t>(LatencyPhase::COUNT)];
+
+        Shard();
+    };
+
+    static const size_t SHARDS = 16;
+
+    // Shard of the calling thread
+    Shard& shard();
+
+    std::unique_ptr<Shard[]> shards_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+} // namespace cfpinner
+
+#endif // SCAN_METRICS_H
@@ -0,0 +1,33 @@
+#ifndef SHARD_MERGE_H
+#define SHARD_MERGE_H
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+namespace cfpinner {
+
+// Combines the outputs of a scan split across hosts with --shard.
+// Records are ordered by IPv4 address with radix sorts and duplicates are
+// dropped in one pass over the sorted records, so merging stays linear in
+// the number of records however many shards there are.
+class ShardMerge {
+public:
+    struct Stats {
+        size_t files = 0;
+        size_t records = 0;     // Read from all inputs
+        size_t duplicates = 0;  // Dropped
+    };
+
+    // Alive lists (binary indexes or text lists) into one alive index;
+    // of several records for an IP, the most recently seen one is kept
+    static bool mergeAlive(const std::vector<std::string>& inputs, const std::string& output, Stats& stats);
+
+    // Binary result files into one. URL tables are combined, records are
+    // ordered by IP, URL and time, and identical records are kept once.
+    static bool mergeResults(const std::vector<std::string>& inputs, const std::string& output, Stats& stats);
+};
+
+} // namespace cfpinner
+
+#endif // SHARD_MERGE_H
@@ -0,0 +1,46 @@
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace cfpinner {
+
+// Hashed timer wheel: timers hash into slots by their due tick, so
+// scheduling is O(1) and advancing the clock only visits the slots that
+// passed. Timers further out than one revolution share slots with nearer
+// ones and are skipped until their tick comes. Ids are opaque to the wheel;
+// scheduling the same id twice yields two timers.
+class TimerWheel {
+public:
+    // tick_ms is the resolution; start_ms is the current time
+    TimerWheel(uint64_t tick_ms, size_t slots, uint64_t start_ms);
+
+    // Fire id at due_ms (times in the past fire with the next tick)
+    void schedule(uint32_t id, uint64_t due_ms);
+
+    // Move the clock to now_ms and append every timer that came due
+    void advance(uint64_t now_ms, std::vector<uint32_t>& expired);
+
+    // Start of the first tick not processed yet; sleeping until then is enough
+    uint64_t nextTickMs() const { return current_tick_ * tick_ms_; }
+
+    size_t size() const { return count_; }
+    bool empty() const { return count_ == 0; }
+
+private:
+    struct Timer {
+        uint32_t id;
+        uint64_t due_tick;
+    };
+
+    uint64_t tick_ms_;
+    uint64_t current_tick_;  // Every tick before this one has been processed
+    std::vector<std::vector<Timer>> slots_;
+    size_t count_;
+};
+
+} // namespace cfpinner
+
+#endif // TIMER_WHEEL_H
@@ -0,0 +1,47 @@
+#ifndef WORK_STEALING_H
+#define WORK_STEALING_H
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <atomic>
+
+namespace cfpinner {
+
+// Hands out an index space [0, total) to a fixed set of workers in small batches.
+// Every worker starts with a contiguous share and takes batches from its
+// front; a worker that runs dry steals the back half of the fullest other
+// share. A slice full of slow (dead) IPs is therefore spread over the idle
+// workers instead of holding up the end of the scan.
+class WorkStealingScheduler {
+public:
+    WorkStealingScheduler(size_t total, size_t num_workers, size_t batch_size = 4);
+
+    WorkStealingScheduler(const WorkStealingScheduler&) = delete;
+    WorkStealingScheduler& operator=(const WorkStealingScheduler&) = delete;
+
+    // Next batch [begin, end) for worker; returns false once no work is left anywhere
+    bool next(size_t worker, size_t& begin, size_t& end);
+
+    // Number of successful steals so far
+    size_t steals() const { return steals_.load(std::memory_order_relaxed); }
+
+private:
+    // One worker's remaining share; padded so workers do not share cache lines
+    struct alignas(64) Share {
+        std::mutex mutex;
+        size_t begin = 0;
+        size_t end = 0;
+    };
+
+    size_t num_workers_;
+    size_t batch_size_;
+    std::unique_ptr<Share[]> shares_;
+    std::atomic<size_t> steals_;
+
+    bool steal(size_t worker);
+};
+
+} // namespace cfpinner
+
+#endif // WORK_STEALING_H
@@ -0,0 +1,250 @@
+#include "alive_index.h"
+#include "result_store.h"
+#include "cidr_utils.h"
+#include "radix_sort.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
+#include <ctime>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace cfpinner {
+
+static const char INDEX_MAGIC[8] = {'C', 'F', 'P', 'A', 'L', 'I', 'V', 'E'};
+
+struct AliveIndexHeader {
+    char magic[8];         // "CFPALIVE"
+    uint32_t version;
+    uint32_t record_size;  // sizeof(AliveRecord)
+    uint64_t count;
+    uint64_t created;      // Unix time
+};
+static_assert(sizeof(AliveIndexHeader) == 32, "AliveIndexHeader is part of the file format");
+
+// Keep one record per IP, the most recently seen. Linear in the number of
+// records, so merging the lists of many scan shards stays cheap.
+static void sortAndDedupe(std::vector<AliveRecord>& records) {
+    radixSort(records, [](const AliveRecord& record) { return record.ip; });
+
+    size_t kept = 0;
+    for (size_t i = 0; i < records.size(); i++) {
+        if (kept > 0 && records[kept - 1].ip == records[i].ip) {
+            if (records[i].last_seen > records[kept - 1].last_seen) {
+                records[kept - 1] = records[i];
+            }
+            continue;
+        }
+        records[kept++] = records[i];
+    }
+    records.resize(kept);
+}
+
+AliveIndex::AliveIndex()
+    : mapping_(nullptr), mapping_size_(0), records_(nullptr), count_(0), created_(0) {
+}
+
+AliveIndex::~AliveIndex() {
+    close();
+}
+
+void AliveIndex::close() {
+    if (mapping_) {
+        munmap(mapping_, mapping_size_);
+        mapping_ = nullptr;
+        mapping_size_ = 0;
+    }
+    imported_.clear();
+    records_ = nullptr;
+    count_ = 0;
+    created_ = 0;
+}
+
+bool AliveIndex::isIndexFile(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    char magic[sizeof(INDEX_MAGIC)] = {};
+    file.read(magic, sizeof(magic));
+    return file && std::memcmp(magic, INDEX_MAGIC, sizeof(INDEX_MAGIC)) == 0;
+}
+
+bool AliveIndex::open(const std::string& path) {
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(AliveIndexHeader)) {
+        ::close(fd);
+        return false;
+    }
+
+    size_t size = static_cast<size_t>(st.st_size);
+    void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        std::cerr << "Failed to map alive index: " << path << std::endl;
+        return false;
+    }
+
+    const AliveIndexHeader* header = static_cast<const AliveIndexHeader*>(mapping);
+    if (std::memcmp(header->magic, INDEX_MAGIC, sizeof(INDEX_MAGIC)) != 0 ||
+        header->version != VERSION ||
+        header->record_size != sizeof(AliveRecord) ||
+        header->count > (size - sizeof(AliveIndexHeader)) / sizeof(AliveRecord)) {
+        std::cerr << "Ignoring invalid or incompatible alive index: " << path << std::endl;
+        munmap(mapping, size);
+        return false;
+    }
+
+    // Records are read in order right after mapping
+    madvise(mapping, size, MADV_WILLNEED);
+
+    mapping_ = mapping;
+    mapping_size_ = size;
+    records_ = reinterpret_cast<const AliveRecord*>(static_cast<const char*>(mapping) + sizeof(AliveIndexHeader));
+    count_ = static_cast<size_t>(header->count);
+    created_ = header->created;
+    return true;
+}
+
+bool AliveIndex::importText(const std::string& path) {
+    close();
+
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    struct stat st;
+    unsigned long modified = stat(path.c_str(), &st) == 0 ? static_cast<unsigned long>(st.st_mtime) : 0;
+
+    std::string line;
+    while (std::getline(file, line)) {
+        // Skip comments and empty lines
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+
+        // "<ip>", "<ip> <iata>" or a full export line
+        std::istringstream fields(line);
+        std::string ip_address;
+        std::string iata = "-";
+        double rtt_ms = 0;
+        unsigned status_code = 0;
+        unsigned long last_seen = modified;
+        if (!(fields >> ip_address)) {
+            continue;
+        }
+        fields >> iata >> rtt_ms >> status_code >> last_seen;
+
+        uint32_t ip;
+        int prefix_len;
+        if (!CIDRUtils::parseCIDR(ip_address, ip, prefix_len) || prefix_len != 32) {
+            continue;
+        }
+
+        AliveRecord record = {};
+        record.ip = ip;
+        record.last_seen = static_cast<uint32_t>(last_seen);
+        record.rtt_us = static_cast<uint32_t>(rtt_ms * 1000);
+        record.iata = ResultStore::encodeIATA(iata.c_str());
+        record.status_code = static_cast<uint16_t>(status_code);
+        imported_.push_back(record);
+    }
+
+    sortAndDedupe(imported_);
+    records_ = imported_.data();
+    count_ = imported_.size();
+    return !imported_.empty();
+}
+
+const AliveRecord* AliveIndex::find(uint32_t ip) const {
+    const AliveRecord* it = std::lower_bound(begin(), end(), ip,
+                                             [](const AliveRecord& record, uint32_t value) { return record.ip < value; });
+    return (it != end() && it->ip == ip) ? it : nullptr;
+}
+
+size_t AliveIndex::freshCount(uint32_t ttl_seconds) const {
+    uint64_t now = static_cast<uint64_t>(time(nullptr));
+    return static_cast<size_t>(std::count_if(begin(), end(), [&](const AliveRecord& record) {
+        return isFresh(record, now, ttl_seconds);
+    }));
+}
+
+bool AliveIndex::write(const std::string& path, std::vector<AliveRecord> records) {
+    sortAndDedupe(records);
+
+    AliveIndexHeader header = {};
+    std::memcpy(header.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC));
+    header.version = VERSION;
+    header.record_size = sizeof(AliveRecord);
+    header.count = records.size();
+    header.created = static_cast<uint64_t>(time(nullptr));
+
+    std::string temp_path = path + ".tmp";
+    std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        std::cerr << "Failed to write alive index: " << temp_path << std::endl;
+        return false;
+    }
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(records.data()),
+               static_cast<std::streamsize>(records.size() * sizeof(AliveRecord)));
+    file.close();
+    if (!file) {
+        std::cerr << "Failed to write alive index: " << temp_path << std::endl;
+        std::remove(temp_path.c_str());
+        return false;
+    }
+
+    if (std::rename(temp_path.c_str(), path.c_str()) != 0) {
+        std::cerr << "Failed to replace alive index: " << path << std::endl;
+        std::remove(temp_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool AliveIndex::exportText(const std::string& path) const {
+    std::ofstream file(path);
+    if (!file.is_open()) {
+        std::cerr << "Failed to export alive IPs to: " << path << std::endl;
+        return false;
+    }
+
+    // Write header
+    file << "# Cloudflare CDN Alive IPs" << std::endl;
+    file << "# IPs that responded with HIT or MISS status" << std::endl;
+
+    time_t created = static_cast<time_t>(created_ ? created_ : time(nullptr));
+    char timestamp[100];
+    strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", localtime(&created));
+    file << "# Scanned: " << timestamp << std::endl;
+    file << "# Total alive: " << count_ << std::endl;
+    file << "# Format: <ip> <iata> <rtt_ms> <status> <last_seen>" << std::endl;
+    file << std::endl;
+
+    for (const AliveRecord* record = begin(); record != end(); record++) {
+        std::string iata = ResultStore::decodeIATA(record->iata);
+        char rtt[16];
+        snprintf(rtt, sizeof(rtt), "%.3f", record->rtt_us / 1000.0);
+        file << CIDRUtils::uint32ToIp(record->ip) << " "
+             << (iata.empty() ? "-" : iata) << " "
+             << rtt << " "
+             << record->status_code << " "
+             << record->last_seen << "\n";
+    }
+
+    file.close();
+    return static_cast<bool>(file);
+}
+
+} // namespace cfpinner
@@ -0,0 +1,92 @@
+#include "buffered_writer.h"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace cfpinner {
+
+BufferedWriter::BufferedWriter(size_t capacity)
+    : buffer_(capacity > 0 ? capacity : DEFAULT_CAPACITY), used_(0), fd_(-1), owns_fd_(false),
+      failed_(false), bytes_written_(0) {
+}
+
+BufferedWriter::~BufferedWriter() {
+    close();
+}
+
+bool BufferedWriter::open(const std::string& path) {
+    close();
+    failed_ = false;
+    bytes_written_ = 0;
+
+    if (path == "-") {
+        fd_ = STDOUT_FILENO;
+        owns_fd_ = false;
+        return true;
+    }
+
+    fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    owns_fd_ = fd_ >= 0;
+    return fd_ >= 0;
+}
+
+void BufferedWriter::writeOut(const char* data, size_t length) {
+    while (length > 0 && !failed_) {
+        ssize_t written = ::write(fd_, data, length);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            failed_ = true;
+            return;
+        }
+        data += written;
+        length -= static_cast<size_t>(written);
+        bytes_written_ += static_cast<size_t>(written);
+    }
+}
+
+void BufferedWriter::append(const char* data, size_t length) {
+    if (used_ + length > buffer_.size()) {
+        flush();
+
+        // Larger than the whole buffer: skip the copy
+        if (length > buffer_.size()) {
+            writeOut(data, length);
+            return;
+        }
+    }
+    std::memcpy(buffer_.data() + used_, data, length);
+    used_ += length;
+}
+
+void BufferedWriter::put(char c) {
+    if (used_ == buffer_.size()) {
+        flush();
+    }
+    buffer_[used_++] = c;
+}
+
+bool BufferedWriter::flush() {
+    if (fd_ >= 0 && used_ > 0) {
+        writeOut(buffer_.data(), used_);
+    }
+    used_ = 0;
+    return !failed_;
+}
+
+bool BufferedWriter::close() {
+    if (fd_ < 0) {
+        return !failed_;
+    }
+    flush();
+    if (owns_fd_ && ::close(fd_) != 0) {
+        failed_ = true;
+    }
+    fd_ = -1;
+    owns_fd_ = false;
+    return !failed_;
+}
+
+} // namespace cfpinner
@@ -1,5 +1,15 @@
 #include "cdn_tracker.h"
 #include "cidr_utils.h"
+#include "connect_scanner.h"
+#include "rtt_estimator.h"
+#include "work_stealing.h"
+#include "result_pipeline.h"
+#include "colo_selector.h"
+#include "timer_wheel.h"
+#include "result_sink.h"
+#include "colo_summary.h"
+#include "dashboard.h"
+#include "scan_checkpoint.h"
 #include <iostream>
 #include <fstream>
 #include <iomanip>
@@ -9,32 +19,162 @@
 #include <thread>
 #include <mutex>
 #include <atomic>
+#include <chrono>
+#include <ctime>
+#include <unordered_map>
+#include <csignal>
 
 namespace cfpinner {
 
-CDNTracker::CDNTracker() : max_ips_per_range_(10), use_specific_ips_(false), force_all_(false), timeout_seconds_(5) {
-    http_client_.setTimeout(timeout_seconds_);
+// Set by SIGINT/SIGTERM while watch() or a checkpointed alive scan runs
+static std::atomic<bool> scan_interrupted(false);
+
+static void onScanSignal(int) {
+    scan_interrupted.store(true);
+}
+
+CDNTracker::CDNTracker() : max_ips_per_range_(10), use_specific_ips_(false), force_all_(false), shard_index_(0),
+                           shard_count_(1), timeout_ms_(5000),
+                           http_connect_timeout_ms_(0), adaptive_timeout_(false), rtt_multiplier_(4.0), max_in_flight_(0),
+                           curl_share_(std::make_shared<CurlShare>()), connect_scan_(false), pin_connect_(false),
+                           connect_scan_timeout_ms_(500), adaptive_concurrency_(false), concurrency_limit_(0), concurrency_action_(""),
+                           max_retries_(1), retry_budget_percent_(10.0), alive_url_("https://www.cloudflare.com/"), per_colo_(0),
+                           metrics_(nullptr), result_sink_(nullptr), show_ip_table_(false),
+                           dashboard_(nullptr), checkpoint_interval_s_(30), resume_(false), interrupted_(false) {
+    http_client_.setTimeoutMs(http_connect_timeout_ms_, timeout_ms_);
+    http_client_.setShare(curl_share_);
 }
 
 CDNTracker::~CDNTracker() {
 }
 
 void CDNTracker::setTimeout(int timeout_seconds) {
-    timeout_seconds_ = timeout_seconds;
-    http_client_.setTimeout(timeout_seconds);
+    setTimeoutMs(http_connect_timeout_ms_, timeout_seconds * 1000L);
+}
+
+void CDNTracker::setTimeoutMs(long connect_timeout_ms, long timeout_ms) {
+    http_connect_timeout_ms_ = connect_timeout_ms;
+    timeout_ms_ = timeout_ms;
+    http_client_.setTimeoutMs(connect_timeout_ms, timeout_ms);
+}
+
+void CDNTracker::setAdaptiveTimeout(bool enabled, double multiplier) {
+    adaptive_timeout_ = enabled;
+    rtt_multiplier_ = multiplier;
 }
 
 void CDNTracker::setForceAll(bool force_all) {
     force_all_ = force_all;
 }
 
+void CDNTracker::setShard(size_t index, size_t count) {
+    shard_count_ = std::max<size_t>(count, 1);
+    shard_index_ = std::min(index, shard_count_ - 1);
+}
+
 void CDNTracker::setMaxIPsPerRange(size_t max_ips) {
     max_ips_per_range_ = max_ips;
 }
 
+void CDNTracker::setMaxInFlight(size_t max_in_flight) {
+    max_in_flight_ = max_in_flight;
+}
+
+void CDNTracker::setAdaptiveConcurrency(bool enabled) {
+    adaptive_concurrency_ = enabled;
+}
+
+void CDNTracker::setRetries(unsigned max_retries, double budget_percent) {
+    max_retries_ = max_retries;
+    retry_budget_percent_ = budget_percent;
+}
+
+void CDNTracker::setAliveURL(const std::string& url) {
+    alive_url_ = url;
+}
+
+void CDNTracker::setProbeObserver(ProbeCallback observer) {
+    probe_observer_ = std::move(observer);
+}
+
+void CDNTracker::setMetrics(ScanMetrics* metrics) {
+    metrics_ = metrics;
+}
+
+void CDNTracker::setResultSink(ResultSink* sink) {
+    result_sink_ = sink;
+}
+
+void CDNTracker::setShowIPTable(bool enabled) {
+    show_ip_table_ = enabled;
+}
+
+void CDNTracker::setDashboard(Dashboard* dashboard) {
+    dashboard_ = dashboard;
+}
+
+void CDNTracker::setCheckpoint(const std::string& path, unsigned interval_s, bool resume) {
+    checkpoint_path_ = path;
+    checkpoint_interval_s_ = std::max(interval_s, 1u);
+    resume_ = resume;
+}
+
+size_t CDNTracker::engineInFlight() const {
+    if (max_in_flight_ > 0) {
+        return max_in_flight_;
+    }
+    return adaptive_concurrency_ ? 4096 : 0;
+}
+
+void CDNTracker::displayConcurrency(size_t num_threads) const {
+    if (adaptive_concurrency_) {
+        std::cout << " with adaptive concurrency (up to " << engineInFlight() << " probes in flight)...\n" << std::endl;
+    } else if (max_in_flight_ > 0) {
+        std::cout << " with up to " << max_in_flight_ << " probes in flight...\n" << std::endl;
+    } else {
+        std::cout << " using " << num_threads << " threads...\n" << std::endl;
+    }
+}
+
+void CDNTracker::setConnectScan(bool enabled, int timeout_ms) {
+    connect_scan_ = enabled;
+    connect_scan_timeout_ms_ = timeout_ms;
+}
+
+void CDNTracker::setPinConnect(bool enabled) {
+    pin_connect_ = enabled;
+}
+
 void CDNTracker::setSpecificIPs(const std::vector<std::string>& ips) {
-    specific_ips_ = ips;
-    use_specific_ips_ = !ips.empty();
+    specific_ips_.clear();
+    for (const auto& ip_address : ips) {
+        AliveRecord record = {};
+        record.ip = CIDRUtils::ipToUint32(ip_address);
+        specific_ips_.push_back(record);
+    }
+    use_specific_ips_ = !specific_ips_.empty();
+}
+
+void CDNTracker::setAliveIndex(const AliveIndex& index, uint32_t ttl_seconds) {
+    // Fixed-size records, copied as mapped; entries past their TTL are skipped
+    uint64_t now = static_cast<uint64_t>(time(nullptr));
+    specific_ips_.clear();
+    specific_ips_.reserve(index.size());
+    for (const AliveRecord* record = index.begin(); record != index.end(); record++) {
+        if (AliveIndex::isFresh(*record, now, ttl_seconds)) {
+            specific_ips_.push_back(*record);
+        }
+    }
+
+    // Fastest first; unknown RTTs (0) last
+    std::stable_sort(specific_ips_.begin(), specific_ips_.end(), [](const AliveRecord& a, const AliveRecord& b) {
+        return a.rtt_us - 1 < b.rtt_us - 1;
+    });
+    use_specific_ips_ = !specific_ips_.empty();
+}
+
+void CDNTracker::setPerColo(size_t per_colo) {
+    per_colo_ = per_colo;
 }
 
 bool CDNTracker::loadIPRanges(const std::string& filename) {
@@ -71,11 +211,16 @@ void CDNTracker::setTargetDomain(const std::string& domain) {
 void CDNTracker::displayProgress(size_t current, size_t total) const {
     int percent = (current * 100) / total;
     std::cout << "\r[" << std::setw(3) << percent << "%] Checking IP "
-              << current << " of " << total << "..." << std::flush;
+              << current << " of " << total << "...";
+    size_t limit = concurrency_limit_.load(std::memory_order_relaxed);
+    if (limit > 0) {
+        std::cout << " [in flight: " << limit << " " << concurrency_action_.load(std::memory_order_relaxed) << "]";
+    }
+    std::cout << std::flush;
 }
 
-std::vector<std::string> CDNTracker::expandAllRanges() const {
-    std::vector<std::string> all_ips;
+IPRangeList CDNTracker::expandAllRanges() const {
+    IPRangeList all_ips;
 
     // If force_all is enabled, use SIZE_MAX to expand everything
     size_t expansion_limit = force_all_ ? SIZE_MAX : max_ips_per_range_;
@@ -86,23 +231,260 @@ std::vector<std::string> CDNTracker::expandAllRanges() const {
             continue;
         }
 
-        std::vector<std::string> ips = CIDRUtils::expandCIDR(ip_range, expansion_limit);
-        all_ips.insert(all_ips.end(), ips.begin(), ips.end());
+        // Addresses are produced on demand while the scan runs
+        all_ips.addRange(ip_range, expansion_limit);
     }
 
+    if (shard_count_ > 1) {
+        return all_ips.shard(shard_index_, shard_count_);
+    }
     return all_ips;
 }
 
-void CDNTracker::displayResult(const CDNCheckResult& result) const {
+void CDNTracker::runProbes(const IPRangeList& ips,
+                           const ProbeBuilder& build_requests,
+                           const ProbeCallback& on_result,
+                           size_t num_threads,
+                           bool multiplex) {
+    // Adaptive deadlines: learn RTTs from successful probes as the scan runs
+    RTTEstimator estimator(rtt_multiplier_, 50, timeout_ms_);
+    if (adaptive_timeout_) {
+        std::cout << "Adaptive timeouts: " << rtt_multiplier_ << "x observed p99 RTT, ceiling "
+                  << timeout_ms_ << "ms\n" << std::endl;
+    }
+
+    auto apply_deadlines = [&](ProbeRequest& request) {
+        if (!adaptive_timeout_) {
+            return;
+        }
+        uint32_t block = RTTEstimator::blockOf(CIDRUtils::ipToUint32(request.ip_address));
+        estimator.deadlines(block, request.connect_timeout_ms, request.timeout_ms);
+        if (request.attempt > 0) {
+            // A retry doubles its deadlines per attempt, like the backoff, up to
+            // the ceiling, so it does not repeat the timeout it failed with
+            long scale = 1L << std::min(request.attempt, 16u);
+            request.connect_timeout_ms = std::min(request.connect_timeout_ms * scale, timeout_ms_);
+            request.timeout_ms = std::min(request.timeout_ms * scale, timeout_ms_);
+        }
+        if (http_connect_timeout_ms_ > 0) {
+            request.connect_timeout_ms = std::min(request.connect_timeout_ms, http_connect_timeout_ms_);
+        }
+    };
+
+    // Probes built by the first pass, which the retry budget is a share of
+    std::atomic<size_t> first_pass_probes(0);
+
+    auto build_with_deadlines = [&](const std::string& ip_address, std::vector<ProbeRequest>& requests) {
+        size_t first = requests.size();
+        build_requests(ip_address, requests);
+        for (size_t i = first; i < requests.size(); i++) {
+            apply_deadlines(requests[i]);
+        }
+        first_pass_probes.fetch_add(requests.size() - first, std::memory_order_relaxed);
+        if (metrics_) {
+            metrics_->probesStarted(requests.size() - first);
+        }
+    };
+
+    // Transient failures are deferred to retry rounds after the main pass,
+    // as long as the probe has attempts left and the budget allows. During
+    // the pass the budget grows with the probes built so far (with a small
+    // floor), so it never exceeds the share of the probes actually sent.
+    std::atomic<size_t> retries_used(0);
+    std::mutex deferred_mutex;
+    std::vector<ProbeRequest> deferred;
+
+    auto on_probe_result = [&](const ProbeRequest& request, const HTTPResponse& response) {
+        if (adaptive_timeout_ && response.success) {
+            uint32_t block = RTTEstimator::blockOf(CIDRUtils::ipToUint32(request.ip_address));
+            estimator.record(block, response.connect_time_us, response.total_time_us);
+        }
+        if (probe_observer_) {
+            probe_observer_(request, response);
+        }
+        if (metrics_) {
+            metrics_->probeCompleted(response);
+        }
+
+        if (!response.success && request.attempt < max_retries_ &&
+            HTTPClient::isTransientError(response.curl_code)) {
+            size_t budget = std::max<size_t>(
+                16, static_cast<size_t>(first_pass_probes.load(std::memory_order_relaxed) * retry_budget_percent_ / 100.0));
+            size_t used = retries_used.load();
+            while (used < budget && !retries_used.compare_exchange_weak(used, used + 1)) {
+            }
+            if (used < budget) {
+                std::lock_guard<std::mutex> lock(deferred_mutex);
+                deferred.push_back(request);
+                deferred.back().attempt++;
+                if (metrics_) {
+                    metrics_->probeRetried();
+                }
+                return;
+            }
+        }
+        on_result(request, response);
+    };
+
+    runProbePass(ips, build_with_deadlines, on_probe_result, num_threads, multiplex);
+
+    // Retry rounds with exponential backoff between them
+    long backoff_ms = 250;
+    for (unsigned round = 1; round <= max_retries_ && !deferred.empty() && !scan_interrupted.load(); round++) {
+        std::vector<ProbeRequest> retries;
+        retries.swap(deferred);
+
+        std::cout << "\r" << std::string(60, ' ') << "\r";
+        std::cout << "Retrying " << retries.size() << " probes with transient failures (round " << round
+                  << ", after " << backoff_ms << "ms)..." << std::endl;
+        std::this_thread::sleep_for(std::chrono::milliseconds(backoff_ms));
+        backoff_ms *= 2;
+
+        // Probes of one IP stay together so they can share a connection
+        std::stable_sort(retries.begin(), retries.end(), [](const ProbeRequest& a, const ProbeRequest& b) {
+            return CIDRUtils::ipToUint32(a.ip_address) < CIDRUtils::ipToUint32(b.ip_address);
+        });
+        std::vector<uint32_t> retry_ips;
+        std::vector<size_t> first_request;
+        IPRangeList retry_list;
+        for (size_t i = 0; i < retries.size(); i++) {
+            uint32_t ip = CIDRUtils::ipToUint32(retries[i].ip_address);
+            if (retry_ips.empty() || retry_ips.back() != ip) {
+                retry_ips.push_back(ip);
+                retry_list.addAddress(ip);
+                first_request.push_back(i);
+            }
+        }
+        first_request.push_back(retries.size());
+
+        // Map each IP back to its slice of deferred requests
+        auto build_retry = [&](const std::string& ip_address, std::vector<ProbeRequest>& requests) {
+            uint32_t ip = CIDRUtils::ipToUint32(ip_address);
+            size_t index = std::lower_bound(retry_ips.begin(), retry_ips.end(), ip) - retry_ips.begin();
+            for (size_t i = first_request[index]; i < first_request[index + 1]; i++) {
+                requests.push_back(retries[i]);
+                apply_deadlines(requests.back());
+            }
+            if (metrics_) {
+                metrics_->probesStarted(first_request[index + 1] - first_request[index]);
+            }
+        };
+
+        runProbePass(retry_list, build_retry, on_probe_result,
+                     std::min(num_threads, std::max<size_t>(retry_ips.size(), 1)), multiplex);
+    }
+}
+
+void CDNTracker::runProbePass(const IPRangeList& ips,
+                              const ProbeBuilder& build_requests,
+                              const ProbeCallback& on_result,
+                              size_t num_threads,
+                              bool multiplex) {
+    if (useProbeEngine()) {
+        // Event-driven mode: a single thread keeps up to engineInFlight() probes open
+        ProbeEngine engine(engineInFlight());
+        engine.setTimeoutMs(http_connect_timeout_ms_, timeout_ms_);
+        engine.setShare(curl_share_);
+        engine.setMultiplex(multiplex);
+
+        // Probes for one IP are handed out back to back so they share a connection
+        size_t next = 0;
+        std::vector<ProbeRequest> batch;
+        size_t batch_pos = 0;
+        auto source = [&](ProbeRequest& request) {
+            while (batch_pos >= batch.size()) {
+                if (next >= ips.size() || scan_interrupted.load()) {
+                    return false;
+                }
+                batch.clear();
+                batch_pos = 0;
+                build_requests(ips.addressAt(next++), batch);
+            }
+            request = std::move(batch[batch_pos++]);
+            return true;
+        };
+
+        if (!adaptive_concurrency_) {
+            engine.run(source, on_result);
+            return;
+        }
+
+        ConcurrencyController controller(16, engine.getMaxInFlight(), 64);
+        engine.setConcurrencyController(&controller);
+        auto on_adaptive_result = [&](const ProbeRequest& request, const HTTPResponse& response) {
+            concurrency_action_.store(controller.lastAction(), std::memory_order_relaxed);
+            concurrency_limit_.store(controller.limit(), std::memory_order_relaxed);
+            on_result(request, response);
+        };
+        engine.run(source, on_adaptive_result);
+        concurrency_limit_.store(0, std::memory_order_relaxed);
+
+        std::cout << "\r" << std::string(60, ' ') << "\r";
+        std::cout << "Adaptive concurrency: finished at " << controller.limit() << " probes in flight (peak "
+                  << controller.peakLimit() << ", " << controller.backoffs() << " backoffs)" << std::endl;
+        return;
+    }
+
+    // Workers pull small batches of IPs and steal from each other when they run dry
+    size_t worker_count = std::max<size_t>(1, std::min(num_threads, ips.size()));
+    WorkStealingScheduler scheduler(ips.size(), worker_count);
+
+    // Worker function for each thread
+    auto worker = [&](size_t worker_index) {
+        // One persistent handle per worker, sessions shared across workers
+        HTTPClient thread_http_client;
+        thread_http_client.setShare(curl_share_);
+
+        std::vector<ProbeRequest> batch;
+        size_t start_idx = 0;
+        size_t end_idx = 0;
+        while (!scan_interrupted.load() && scheduler.next(worker_index, start_idx, end_idx)) {
+            for (size_t i = start_idx; i < end_idx; i++) {
+                batch.clear();
+                build_requests(ips.addressAt(i), batch);
+                for (const auto& request : batch) {
+                    thread_http_client.setTimeoutMs(
+                        request.connect_timeout_ms >= 0 ? request.connect_timeout_ms : http_connect_timeout_ms_,
+                        request.timeout_ms >= 0 ? request.timeout_ms : timeout_ms_);
+
+                    const ProbeTarget& target = *request.target;
+                    HTTPResponse response;
+                    if (target.pin_connect) {
+                        std::string connect_to = target.connectTo(request.ip_address);
+                        response = thread_http_client.head(target.url,
+                                                           target.needsHostHeader() ? target.host : std::string(),
+                                                           connect_to.c_str());
+                    } else {
+                        response = thread_http_client.head(target.urlForIP(request.ip_address), target.host);
+                    }
+                    on_result(request, response);
+                }
+            }
+        }
+    };
+
+    // Create thread pool
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < worker_count; t++) {
+        threads.emplace_back(worker, t);
+    }
+
+    // Wait for all threads to complete
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+void CDNTracker::displayResult(const ResultStore& results, size_t index, const char* label) const {
     std::string status_icon;
     std::string status_text;
     std::string color_code;
 
-    if (!result.error_message.empty()) {
+    if (results.isError(index)) {
         status_icon = "✗";
         status_text = "ERROR";
         color_code = "\033[31m"; // Red
-    } else if (result.is_hit) {
+    } else if (!label && results.isHit(index)) {
         status_icon = "✓";
         status_text = "HIT";
         color_code = "\033[32m"; // Green
@@ -115,43 +497,78 @@ void CDNTracker::displayResult(const CDNCheckResult& result) const {
     std::string reset_code = "\033[0m";
 
     std::cout << std::left
-              << std::setw(20) << result.ip_address
+              << std::setw(20) << results.ipString(index)
               << " " << color_code << status_icon << " " << status_text << reset_code;
 
-    if (!result.error_message.empty()) {
-        std::cout << " (" << result.error_message << ")";
-    } else if (!result.cache_status.empty()) {
-        std::cout << " [" << result.cache_status << "]";
+    if (results.isError(index)) {
+        std::cout << " (" << ResultStore::errorClassName(results.error(index)) << ")";
+    } else if (label) {
+        std::cout << " [" << label << "]";
+    } else if (results.cacheStatus(index) != CacheStatus::NONE) {
+        std::cout << " [" << ResultStore::cacheStatusName(results.cacheStatus(index)) << "]";
     }
 
-    std::cout << std::endl;
+    // No flush per line; the result consumer flushes when it runs dry
+    std::cout << '\n';
 }
 
-void CDNTracker::displaySummary(const std::vector<CDNCheckResult>& results) const {
-    int hits = 0;
-    int misses = 0;
-    int errors = 0;
-
-    for (const auto& result : results) {
-        if (!result.error_message.empty()) {
-            errors++;
-        } else if (result.is_hit) {
-            hits++;
-        } else {
-            misses++;
-        }
-    }
+void CDNTracker::displaySummary(const ResultStore& results) const {
+    ResultStore::Counts counts = results.count();
 
     std::cout << "\n" << std::string(50, '=') << std::endl;
     std::cout << "Summary:" << std::endl;
-    std::cout << "  Total checked: " << results.size() << std::endl;
-    std::cout << "  \033[32mHITS:  " << hits << "\033[0m" << std::endl;
-    std::cout << "  \033[33mMISSES: " << misses << "\033[0m" << std::endl;
-    std::cout << "  \033[31mERRORS: " << errors << "\033[0m" << std::endl;
+    std::cout << "  Total checked: " << counts.total << std::endl;
+    std::cout << "  \033[32mHITS:  " << counts.hits << "\033[0m" << std::endl;
+    std::cout << "  \033[33mMISSES: " << counts.misses << "\033[0m" << std::endl;
+    std::cout << "  \033[31mERRORS: " << counts.errors << "\033[0m" << std::endl;
     std::cout << std::string(50, '=') << std::endl;
 }
 
-std::vector<std::string> CDNTracker::scanAliveNodes(size_t num_threads) {
+IPRangeList CDNTracker::connectScan(const IPRangeList& ips, ScanCheckpoint* checkpoint) {
+    // Half-open connects are cheap, so allow far more of them than HEAD probes
+    ConnectScanner scanner(max_in_flight_ > 0 ? std::max<size_t>(max_in_flight_, 20000) : 20000);
+    int port = ProbeTarget::fromURL(alive_url_, false).port;
+    scanner.setTimeoutMs(connect_scan_timeout_ms_);
+    scanner.setPort(static_cast<uint16_t>(port));
+
+    std::cout << "Connect-scanning " << ips.size() << " IPs on port " << port << " ("
+              << connect_scan_timeout_ms_ << "ms timeout)...\n" << std::endl;
+
+    IPRangeList open_ips;
+    size_t completed = 0;
+
+    // A checkpointed scan can be interrupted here too; closed ports are
+    // saved on the same interval as HEAD results
+    auto checkpoint_due = std::chrono::steady_clock::now() + std::chrono::seconds(checkpoint_interval_s_);
+    if (checkpoint) {
+        scanner.setStopFlag(&scan_interrupted);
+    }
+
+    // The scanner runs on this thread only, so no locking is needed
+    scanner.scan(ips, [&](uint32_t ip, bool is_open) {
+        if (is_open) {
+            open_ips.addAddress(ip);
+        } else if (checkpoint) {
+            checkpoint->markDone(ip);
+            auto now = std::chrono::steady_clock::now();
+            if (now >= checkpoint_due) {
+                checkpoint->save(checkpoint_path_);
+                checkpoint_due = now + std::chrono::seconds(checkpoint_interval_s_);
+            }
+        }
+        completed++;
+        if (completed % 1000 == 0 || completed == ips.size()) {
+            displayProgress(completed, ips.size());
+        }
+    });
+
+    std::cout << "\r" << std::string(60, ' ') << "\r"; // Clear progress line
+    std::cout << open_ips.size() << " of " << ips.size() << " IPs accepted a connection" << std::endl;
+    return open_ips;
+}
+
+std::vector<AliveRecord> CDNTracker::scanAliveNodes(size_t num_threads) {
+    interrupted_ = false;
     if (ip_ranges_.empty()) {
         std::cerr << "No IP ranges loaded. Use loadIPRanges() first." << std::endl;
         return {};
@@ -162,8 +579,103 @@ std::vector<std::string> CDNTracker::scanAliveNodes(size_t num_threads) {
     if (force_all_) {
         std::cout << " (FULL expansion - no sampling)";
     }
+    if (shard_count_ > 1) {
+        std::cout << ", shard " << (shard_index_ + 1) << " of " << shard_count_;
+    }
     std::cout << "..." << std::endl;
 
+    IPRangeList all_ips = expandAliveRanges();
+    size_t tested_count = all_ips.size();
+
+    // Progress is checkpointed so that an interrupted scan can be resumed
+    std::unique_ptr<ScanCheckpoint> checkpoint;
+    if (!checkpoint_path_.empty()) {
+        checkpoint.reset(new ScanCheckpoint());
+        checkpoint->reset(ip_ranges_, aliveScanKey());
+        if (resume_ && checkpoint->load(checkpoint_path_)) {
+            // Only the IPs the checkpoint has not seen are probed again
+            IPRangeList remaining;
+            IPRangeList::Cursor cursor(all_ips);
+            uint32_t ip;
+            while (cursor.next(ip)) {
+                if (!checkpoint->isDone(ip)) {
+                    remaining.addAddress(ip);
+                }
+            }
+            std::cout << "Resuming from " << checkpoint_path_ << ": " << (tested_count - remaining.size())
+                      << " of " << tested_count << " IPs already probed, " << checkpoint->records().size()
+                      << " alive so far" << std::endl;
+            all_ips = std::move(remaining);
+        } else if (resume_) {
+            std::cout << "No checkpoint to resume at " << checkpoint_path_ << ", starting a new scan" << std::endl;
+        }
+    }
+
+    std::vector<AliveRecord> alive_records;
+    if (!all_ips.empty()) {
+        auto previous_int = SIG_DFL;
+        auto previous_term = SIG_DFL;
+        if (checkpoint) {
+            scan_interrupted.store(false);
+            previous_int = std::signal(SIGINT, onScanSignal);
+            previous_term = std::signal(SIGTERM, onScanSignal);
+        }
+
+        // Connect-only pre-pass: only IPs that accept a TCP connection on the alive URL's port (443)
+        // go on to the full HEAD check
+        if (connect_scan_) {
+            all_ips = connectScan(all_ips, checkpoint.get());
+            if (scan_interrupted.load()) {
+                // Open IPs found so far are not marked done and get probed on resume
+                all_ips = IPRangeList();
+            } else if (all_ips.empty()) {
+                std::cout << "No IPs accepted a connection" << std::endl;
+            } else {
+                std::cout << "Verifying " << all_ips.size() << " open IPs with HTTPS HEAD requests..." << std::endl;
+            }
+        }
+        if (!all_ips.empty()) {
+            alive_records = probeAliveNodes(all_ips, num_threads, checkpoint.get());
+        } else if (checkpoint) {
+            alive_records = checkpoint->records();
+        }
+
+        if (checkpoint) {
+            std::signal(SIGINT, previous_int);
+            std::signal(SIGTERM, previous_term);
+            interrupted_ = scan_interrupted.exchange(false);
+        }
+    } else if (checkpoint) {
+        alive_records = checkpoint->records();
+    }
+
+    if (interrupted_) {
+        checkpoint->save(checkpoint_path_);
+        std::cout << "\n\033[33mScan interrupted after " << checkpoint->completed() << " of " << tested_count
+                  << " IPs (" << alive_records.size() << " alive so far)\033[0m" << std::endl;
+        std::cout << "Progress saved to: " << checkpoint_path_ << std::endl;
+        std::cout << "Continue with: cfpinner --alive --resume (same options)" << std::endl;
+        return alive_records;
+    }
+
+    std::cout << "\n\033[32m✓ Scan complete!\033[0m" << std::endl;
+    std::cout << "Found " << alive_records.size() << " alive CDN nodes out of "
+              << tested_count << " tested" << std::endl;
+    return alive_records;
+}
+
+uint64_t CDNTracker::aliveScanKey() const {
+    // The same ranges, sampling and URL give the same targets
+    std::vector<std::string> parts(ip_ranges_);
+    parts.push_back(force_all_ ? "all" : "sample:100");
+    if (shard_count_ > 1) {
+        parts.push_back("shard:" + std::to_string(shard_index_) + "/" + std::to_string(shard_count_));
+    }
+    parts.push_back(alive_url_);
+    return ScanCheckpoint::fingerprint(parts);
+}
+
+IPRangeList CDNTracker::expandAliveRanges() {
     // For alive scan, we want comprehensive coverage
     // Sample more IPs per range than default tracking (100 vs 10)
     size_t saved_max = max_ips_per_range_;
@@ -171,95 +683,199 @@ std::vector<std::string> CDNTracker::scanAliveNodes(size_t num_threads) {
         max_ips_per_range_ = 100;  // Much more aggressive sampling for alive scan
     }
 
-    std::vector<std::string> all_ips = expandAllRanges();
+    IPRangeList all_ips = expandAllRanges();
 
     // Restore original setting
     max_ips_per_range_ = saved_max;
+    return all_ips;
+}
 
-    std::cout << "Testing " << all_ips.size() << " Cloudflare CDN IPs using " << num_threads << " threads...\n" << std::endl;
-    std::cout << "\033[33mNote: This will take approximately "
-              << (all_ips.size() * timeout_seconds_ / 60 / num_threads) << " minutes to complete.\033[0m\n" << std::endl;
+// Alive record of a result, seen at now
+static AliveRecord aliveRecordOf(const ResultStore& results, size_t index, uint32_t now) {
+    AliveRecord record = {};
+    record.ip = results.ip(index);
+    record.last_seen = now;
+    record.rtt_us = results.connectTimeUs(index);
+    record.iata = results.iata(index);
+    record.status_code = results.statusCode(index);
+    return record;
+}
 
-    // Thread-safe containers
-    std::vector<std::string> alive_ips;
-    std::mutex alive_ips_mutex;
-    std::mutex console_mutex;
-    std::atomic<size_t> completed_count(0);
+std::vector<AliveRecord> CDNTracker::probeAliveNodes(const IPRangeList& all_ips, size_t num_threads,
+                                                     ScanCheckpoint* checkpoint) {
+    // Concurrency is either the worker thread count or the in-flight probe limit
+    size_t concurrency = useProbeEngine() ? engineInFlight() : num_threads;
+    std::cout << "Testing " << all_ips.size() << " Cloudflare CDN IPs";
+    displayConcurrency(num_threads);
+    std::cout << "\033[33mNote: This will take approximately "
+              << (all_ips.size() * timeout_ms_ / 60000 / concurrency) << " minutes to complete.\033[0m\n" << std::endl;
 
-    // Worker function for each thread
-    auto worker = [&](size_t start_idx, size_t end_idx) {
-        HTTPClient thread_http_client;
-        thread_http_client.setTimeout(timeout_seconds_);
+    // Owned by the result consumer thread
+    ResultStore alive;
+    size_t completed_count = 0;
 
-        std::string domain = "www.cloudflare.com";
+    const ProbeTarget alive_target = ProbeTarget::fromURL(alive_url_, pin_connect_);
 
-        for (size_t i = start_idx; i < end_idx && i < all_ips.size(); i++) {
-            const std::string& ip_address = all_ips[i];
+    auto build_requests = [&](const std::string& ip_address, std::vector<ProbeRequest>& requests) {
+        ProbeRequest request;
+        request.ip_address = ip_address;
+        request.target = &alive_target;
+        requests.push_back(std::move(request));
+    };
 
-            // Build test URL with IP
-            std::string url = "https://" + ip_address + "/";
+    std::vector<TrackJob> alive_jobs = {TrackJob{"alive", alive_url_}};
+    if (result_sink_) {
+        result_sink_->begin(alive_jobs);
+    }
+    if (dashboard_) {
+        dashboard_->begin(alive_jobs, all_ips.size(), "Alive scan");
+    }
+    bool use_dashboard = dashboard_ && dashboard_->active();
 
-            // Make request
-            HTTPResponse response = thread_http_client.head(url, domain);
+    // The checkpoint is saved from the consumer thread, which owns it
+    auto checkpoint_due = std::chrono::steady_clock::now() + std::chrono::seconds(checkpoint_interval_s_);
 
-            // Consider IP alive if we got any response
-            bool is_alive = response.success && response.status_code > 0;
+    ResultPipeline pipeline([&](const ResultEvent& event) {
+        if (result_sink_) {
+            result_sink_->write(event);
+        }
 
+        // Consider IP alive if we got any response
+        bool is_alive = event.success && event.status_code > 0;
+        if (is_alive) {
+            alive.add(event);
+        }
+        if (checkpoint) {
+            checkpoint->markDone(event.ip);
             if (is_alive) {
-                {
-                    std::lock_guard<std::mutex> lock(alive_ips_mutex);
-                    alive_ips.push_back(ip_address);
-                }
-
-                // Display result
-                {
-                    std::lock_guard<std::mutex> lock(console_mutex);
-                    CDNCheckResult result;
-                    result.ip_address = ip_address;
-                    result.status_code = response.status_code;
-                    result.is_hit = false;
-                    result.cache_status = "ALIVE";
-                    std::cout << "\r" << std::string(60, ' ') << "\r";
-                    displayResult(result);
-                }
+                checkpoint->addRecord(aliveRecordOf(alive, alive.size() - 1, static_cast<uint32_t>(time(nullptr))));
             }
-
-            // Update progress
-            size_t current = ++completed_count;
-            if (current % 10 == 0 || current == all_ips.size()) {
-                std::lock_guard<std::mutex> lock(console_mutex);
-                displayProgress(current, all_ips.size());
+            auto now = std::chrono::steady_clock::now();
+            if (now >= checkpoint_due) {
+                checkpoint->save(checkpoint_path_);
+                checkpoint_due = now + std::chrono::seconds(checkpoint_interval_s_);
             }
         }
+        if (use_dashboard) {
+            dashboard_->add(event);
+            return;
+        }
+
+        if (is_alive) {
+            std::cout << "\r" << std::string(60, ' ') << "\r";
+            displayResult(alive, alive.size() - 1, "ALIVE");
+        }
+
+        // Update progress
+        size_t current = ++completed_count;
+        if (current % 10 == 0 || current == all_ips.size()) {
+            displayProgress(current, all_ips.size());
+        }
+    }, []() { std::cout.flush(); });
+
+    auto on_result = [&](const ProbeRequest& request, const HTTPResponse& response) {
+        pipeline.publish(ResultEvent::fromProbe(request, response));
     };
 
-    // Create thread pool
-    std::vector<std::thread> threads;
-    size_t ips_per_thread = (all_ips.size() + num_threads - 1) / num_threads;
+    runProbes(all_ips, build_requests, on_result, num_threads);
+    pipeline.finish();
+    if (use_dashboard) {
+        dashboard_->end();
+    }
 
-    for (size_t t = 0; t < num_threads; t++) {
-        size_t start_idx = t * ips_per_thread;
-        size_t end_idx = std::min(start_idx + ips_per_thread, all_ips.size());
+    std::cout << "\r" << std::string(60, ' ') << "\r"; // Clear progress line
 
-        if (start_idx < all_ips.size()) {
-            threads.emplace_back(worker, start_idx, end_idx);
+    // The checkpoint also holds what earlier runs of the scan found
+    if (checkpoint) {
+        return checkpoint->records();
+    }
+
+    // Keep the colo each IP answered from (for --per-colo), its RTT and status
+    std::vector<AliveRecord> alive_records;
+    alive_records.reserve(alive.size());
+    uint32_t now = static_cast<uint32_t>(time(nullptr));
+    for (size_t i = 0; i < alive.size(); i++) {
+        alive_records.push_back(aliveRecordOf(alive, i, now));
+    }
+    return alive_records;
+}
+
+std::vector<AliveRecord> CDNTracker::refreshAliveNodes(const AliveIndex& index, uint32_t ttl_seconds,
+                                                       size_t dead_sample, size_t num_threads) {
+    uint64_t now = static_cast<uint64_t>(time(nullptr));
+
+    // Re-probe only the entries past their TTL
+    IPRangeList targets;
+    size_t stale = 0;
+    for (const AliveRecord* record = index.begin(); record != index.end(); record++) {
+        if (!AliveIndex::isFresh(*record, now, ttl_seconds)) {
+            targets.addAddress(record->ip);
+            stale++;
         }
     }
 
-    // Wait for all threads to complete
-    for (auto& thread : threads) {
-        thread.join();
+    // Plus a sample of the addresses a full scan would probe that are not in
+    // the cache. The sample is spread evenly over the ranges and its offset
+    // moves every hour, so successive refreshes cover different addresses.
+    size_t sampled = 0;
+    if (dead_sample > 0 && !ip_ranges_.empty()) {
+        IPRangeList candidates = expandAliveRanges();
+        if (!candidates.empty()) {
+            size_t stride = std::max<size_t>(candidates.size() / dead_sample, 1);
+            for (size_t position = static_cast<size_t>(now / 3600) % stride;
+                 position < candidates.size() && sampled < dead_sample; position += stride) {
+                uint32_t ip = candidates.at(position);
+                if (!index.find(ip)) {
+                    targets.addAddress(ip);
+                    sampled++;
+                }
+            }
+        }
     }
 
-    std::cout << "\r" << std::string(60, ' ') << "\r"; // Clear progress line
-    std::cout << "\n\033[32m✓ Scan complete!\033[0m" << std::endl;
-    std::cout << "Found " << alive_ips.size() << " alive CDN nodes out of "
-              << all_ips.size() << " tested" << std::endl;
+    std::cout << "\nRefreshing alive cache: " << stale << " of " << index.size()
+              << " entries past their TTL, " << sampled << " other addresses sampled" << std::endl;
+
+    std::vector<AliveRecord> probed;
+    if (!targets.empty()) {
+        probed = probeAliveNodes(targets, num_threads);
+    }
+
+    // Merge: fresh entries stay, stale ones are updated or dropped, new nodes are added
+    std::unordered_map<uint32_t, AliveRecord> answered;
+    for (const auto& record : probed) {
+        answered[record.ip] = record;
+    }
+
+    std::vector<AliveRecord> merged;
+    merged.reserve(index.size() + answered.size());
+    size_t kept = 0;
+    size_t dropped = 0;
+    for (const AliveRecord* record = index.begin(); record != index.end(); record++) {
+        if (AliveIndex::isFresh(*record, now, ttl_seconds)) {
+            merged.push_back(*record);
+            continue;
+        }
+        auto it = answered.find(record->ip);
+        if (it != answered.end()) {
+            merged.push_back(it->second);
+            answered.erase(it);
+            kept++;
+        } else {
+            dropped++;
+        }
+    }
+    for (const auto& entry : answered) {
+        merged.push_back(entry.second);
+    }
 
-    return alive_ips;
+    std::cout << "\n\033[32m✓ Refresh complete!\033[0m" << std::endl;
+    std::cout << "Stale entries: " << kept << " still alive, " << dropped << " dropped; "
+              << answered.size() << " new nodes found; " << merged.size() << " alive nodes cached" << std::endl;
+    return merged;
 }
 
-void CDNTracker::displayResultsTable(const std::vector<CDNCheckResult>& results) const {
+void CDNTracker::displayResultsTable(const ResultStore& results, int url_index) const {
     // ANSI color codes
     const std::string color_green = "\033[32m";
     const std::string color_yellow = "\033[33m";
@@ -267,16 +883,7 @@ void CDNTracker::displayResultsTable(const std::vector<CDNCheckResult>& results)
     const std::string color_reset = "\033[0m";
 
     // Calculate statistics
-    int hits = 0, misses = 0, errors = 0;
-    for (const auto& result : results) {
-        if (!result.error_message.empty()) {
-            errors++;
-        } else if (result.is_hit) {
-            hits++;
-        } else {
-            misses++;
-        }
-    }
+    ResultStore::Counts counts = results.count(url_index);
 
     // Column widths
     const int col_ip = 18;
@@ -313,15 +920,19 @@ void CDNTracker::displayResultsTable(const std::vector<CDNCheckResult>& results)
               << "+\n";
 
     // Print each result
-    for (const auto& result : results) {
+    for (size_t i = 0; i < results.size(); i++) {
+        if (url_index >= 0 && results.urlIndex(i) != url_index) {
+            continue;
+        }
+
         // Determine status and color
         std::string status_text;
         std::string color_code;
 
-        if (!result.error_message.empty()) {
+        if (results.isError(i)) {
             status_text = "ERROR";
             color_code = color_red;
-        } else if (result.is_hit) {
+        } else if (results.isHit(i)) {
             status_text = "HIT";
             color_code = color_green;
         } else {
@@ -330,22 +941,22 @@ void CDNTracker::displayResultsTable(const std::vector<CDNCheckResult>& results)
         }
 
         // Format fields
-        std::string ip = result.ip_address;
+        std::string ip = results.ipString(i);
         if (ip.length() > col_ip - 2) ip = ip.substr(0, col_ip - 5) + "...";
 
-        std::string cache = result.cache_status;
+        std::string cache = ResultStore::cacheStatusName(results.cacheStatus(i));
         if (cache.empty()) cache = "-";
         if (cache.length() > col_cache - 2) cache = cache.substr(0, col_cache - 5) + "...";
 
-        std::string iata = result.cf_iata_code;
+        std::string iata = results.iataString(i);
         if (iata.empty()) iata = "-";
         if (iata.length() > col_iata - 2) iata = iata.substr(0, col_iata - 5) + "...";
 
-        std::string country = result.cf_ip_country;
+        std::string country = results.countryString(i);
         if (country.empty()) country = "-";
         if (country.length() > col_country - 2) country = country.substr(0, col_country - 5) + "...";
 
-        std::string ray = result.cf_ray;
+        std::string ray = results.rayString(i);
         if (ray.empty()) ray = "-";
         if (ray.length() > col_ray - 2) ray = ray.substr(0, col_ray - 5) + "...";
 
@@ -368,150 +979,553 @@ void CDNTracker::displayResultsTable(const std::vector<CDNCheckResult>& results)
               << "+" << std::string(col_ray, '-')
               << "+\n";
 
-    // Print summary
-    float hit_percent = results.size() > 0 ? (hits * 100.0f / results.size()) : 0.0f;
-    float miss_percent = results.size() > 0 ? (misses * 100.0f / results.size()) : 0.0f;
-    float error_percent = results.size() > 0 ? (errors * 100.0f / results.size()) : 0.0f;
+    displayCounts(counts);
+}
+
+void CDNTracker::displayCounts(const ResultStore::Counts& counts) const {
+    const std::string color_green = "\033[32m";
+    const std::string color_yellow = "\033[33m";
+    const std::string color_red = "\033[31m";
+    const std::string color_reset = "\033[0m";
+
+    float hit_percent = counts.total > 0 ? (counts.hits * 100.0f / counts.total) : 0.0f;
+    float miss_percent = counts.total > 0 ? (counts.misses * 100.0f / counts.total) : 0.0f;
+    float error_percent = counts.total > 0 ? (counts.errors * 100.0f / counts.total) : 0.0f;
 
-    std::cout << "\nSummary: " << results.size() << " total checks, "
-              << color_green << hits << " HITs (" << std::fixed << std::setprecision(1) << hit_percent << "%)" << color_reset << ", "
-              << color_yellow << misses << " MISSes (" << miss_percent << "%)" << color_reset << ", "
-              << color_red << errors << " ERRORs (" << error_percent << "%)" << color_reset << "\n";
+    std::cout << "\nSummary: " << counts.total << " total checks, "
+              << color_green << counts.hits << " HITs (" << std::fixed << std::setprecision(1) << hit_percent << "%)" << color_reset << ", "
+              << color_yellow << counts.misses << " MISSes (" << miss_percent << "%)" << color_reset << ", "
+              << color_red << counts.errors << " ERRORs (" << error_percent << "%)" << color_reset << "\n";
 }
 
-void CDNTracker::track(const std::string& identifier, const std::string& target_url, size_t num_threads) {
-    if (!use_specific_ips_ && ip_ranges_.empty()) {
-        std::cerr << "No IP ranges loaded. Use loadIPRanges() first." << std::endl;
-        return;
+void CDNTracker::displayResults(const ResultStore& results, int url_index) const {
+    if (show_ip_table_) {
+        displayResultsTable(results, url_index);
+    } else {
+        displayColoSummary(results, url_index);
     }
+}
 
-    std::cout << "\nTracking image: " << identifier << std::endl;
-    std::cout << "Target URL: " << target_url << std::endl;
+void CDNTracker::displayColoSummary(const ResultStore& results, int url_index) const {
+    const std::string color_green = "\033[32m";
+    const std::string color_yellow = "\033[33m";
+    const std::string color_red = "\033[31m";
+    const std::string color_reset = "\033[0m";
 
-    // Get IPs to check (either specific alive list or expanded ranges)
-    std::vector<std::string> all_ips;
+    // Errors carry no colo; attribute them to the colo the alive cache knows
+    std::vector<std::pair<uint32_t, uint16_t>> known_colos;
     if (use_specific_ips_) {
-        all_ips = specific_ips_;
+        for (const auto& record : specific_ips_) {
+            if (record.iata != 0) {
+                known_colos.emplace_back(record.ip, record.iata);
+            }
+        }
+        std::sort(known_colos.begin(), known_colos.end());
+    }
+    auto known_colo = [&](uint32_t ip) -> uint16_t {
+        auto it = std::lower_bound(known_colos.begin(), known_colos.end(), std::make_pair(ip, uint16_t(0)));
+        return (it != known_colos.end() && it->first == ip) ? it->second : 0;
+    };
+
+    ColoSummary summary;
+    for (size_t i = 0; i < results.size(); i++) {
+        if (url_index >= 0 && results.urlIndex(i) != url_index) {
+            continue;
+        }
+        summary.add(results, i, results.isError(i) ? known_colo(results.ip(i)) : 0);
+    }
+
+    // Column widths
+    const int col_colo = 8;
+    const int col_country = 10;
+    const int col_count = 9;
+    const int col_latency = 14;
+
+    auto border = [&]() {
+        std::cout << "+" << std::string(col_colo, '-')
+                  << "+" << std::string(col_country, '-')
+                  << "+" << std::string(col_count, '-')
+                  << "+" << std::string(col_count, '-')
+                  << "+" << std::string(col_count, '-')
+                  << "+" << std::string(col_latency, '-')
+                  << "+" << std::string(col_latency, '-')
+                  << "+\n";
+    };
+
+    std::cout << "\n";
+    border();
+    std::cout << "| " << std::left << std::setw(col_colo - 1) << "Colo"
+              << "| " << std::setw(col_country - 1) << "Country"
+              << "| " << std::setw(col_count - 1) << "HIT"
+              << "| " << std::setw(col_count - 1) << "MISS"
+              << "| " << std::setw(col_count - 1) << "ERROR"
+              << "| " << std::setw(col_latency - 1) << "Connect avg"
+              << "| " << std::setw(col_latency - 1) << "Connect min"
+              << "|\n";
+    border();
+
+    for (const auto& colo : summary.sorted()) {
+        std::string iata = ResultStore::decodeIATA(colo.iata);
+        std::string country = ResultStore::decodeCountry(colo.country);
+
+        std::string mean = "-";
+        std::string min = "-";
+        if (colo.connect_samples > 0) {
+            char value[32];
+            snprintf(value, sizeof(value), "%.1f ms", colo.meanConnectMs());
+            mean = value;
+            snprintf(value, sizeof(value), "%.1f ms", colo.min_connect_us / 1000.0);
+            min = value;
+        }
+
+        // Counts are colored only when non-zero so the table stays readable
+        auto count_cell = [&](size_t count, const std::string& color) {
+            std::ostringstream cell;
+            cell << std::left << std::setw(col_count - 1) << count;
+            return count ? color + cell.str() + color_reset : cell.str();
+        };
+
+        std::cout << "| " << std::left << std::setw(col_colo - 1) << (iata.empty() ? "-" : iata)
+                  << "| " << std::setw(col_country - 1) << (country.empty() ? "-" : country)
+                  << "| " << count_cell(colo.hits, color_green)
+                  << "| " << count_cell(colo.misses, color_yellow)
+                  << "| " << count_cell(colo.errors, color_red)
+                  << "| " << std::setw(col_latency - 1) << mean
+                  << "| " << std::setw(col_latency - 1) << min
+                  << "|\n";
+    }
+    border();
+
+    std::cout << summary.size() << (summary.size() == 1 ? " colo" : " colos");
+    if (!show_ip_table_) {
+        std::cout << " (use --table to list every IP)";
+    }
+    std::cout << "\n";
+    displayCounts(results.count(url_index));
+}
+
+IPRangeList CDNTracker::selectTrackTargets(std::unique_ptr<ColoSelector>& colo_selector) {
+    // With colos known from the alive scan, probe only a few IPs per colo
+    if (per_colo_ > 0 && use_specific_ips_) {
+        bool have_colos = std::any_of(specific_ips_.begin(), specific_ips_.end(),
+                                      [](const AliveRecord& record) { return record.iata != 0; });
+        if (have_colos) {
+            colo_selector.reset(new ColoSelector(specific_ips_, per_colo_));
+        } else {
+            std::cout << "\033[33mAlive IPs cache has no colo codes, probing every IP. "
+                      << "Run 'cfpinner --alive' to record them.\033[0m" << std::endl;
+        }
+    }
+
+    // Get IPs to check (either specific alive list or expanded ranges)
+    IPRangeList all_ips;
+    if (colo_selector) {
+        all_ips = colo_selector->representatives();
+        std::cout << "Using cached alive IPs list: " << all_ips.size() << " of " << specific_ips_.size()
+                  << " IPs (" << per_colo_ << " per colo, " << colo_selector->coloCount() << " colos)" << std::endl;
+    } else if (use_specific_ips_) {
+        for (const auto& record : specific_ips_) {
+            all_ips.addAddress(record.ip);
+        }
         std::cout << "Using cached alive IPs list (" << all_ips.size() << " IPs)" << std::endl;
     } else {
         std::cout << "Expanding " << ip_ranges_.size() << " CIDR ranges..." << std::endl;
         all_ips = expandAllRanges();
     }
+    return all_ips;
+}
 
-    std::cout << "Checking " << all_ips.size() << " Cloudflare CDN IPs using " << num_threads << " threads...\n" << std::endl;
+void CDNTracker::track(const std::string& identifier, const std::string& target_url, size_t num_threads) {
+    track(identifier, std::vector<std::string>{target_url}, num_threads);
+}
 
-    // Extract domain from URL if not set
-    std::string url_to_check = target_url;
-    if (url_to_check.find("http://") != 0 && url_to_check.find("https://") != 0) {
-        url_to_check = "https://" + url_to_check;
+void CDNTracker::track(const std::string& identifier, const std::vector<std::string>& target_urls, size_t num_threads) {
+    std::vector<TrackJob> jobs;
+    for (const auto& target_url : target_urls) {
+        jobs.push_back({identifier, target_url});
     }
+    track(jobs, num_threads);
+}
 
-    std::string domain = target_domain_;
-    if (domain.empty()) {
-        size_t start = url_to_check.find("://");
-        if (start != std::string::npos) {
-            start += 3;
-            size_t end = url_to_check.find('/', start);
-            if (end != std::string::npos) {
-                domain = url_to_check.substr(start, end - start);
-            } else {
-                domain = url_to_check.substr(start);
-            }
+void CDNTracker::track(const std::vector<TrackJob>& jobs, size_t num_threads) {
+    if (!use_specific_ips_ && ip_ranges_.empty()) {
+        std::cerr << "No IP ranges loaded. Use loadIPRanges() first." << std::endl;
+        return;
+    }
+    if (jobs.empty()) {
+        std::cerr << "No target URLs given." << std::endl;
+        return;
+    }
+    if (jobs.size() > UINT16_MAX) {
+        std::cerr << "Too many URLs in one pass (max " << UINT16_MAX << ")." << std::endl;
+        return;
+    }
+
+    // Identifiers in job order, each with the jobs (URL indices) it owns
+    std::vector<std::string> identifiers;
+    std::vector<std::vector<size_t>> jobs_of;
+    for (size_t j = 0; j < jobs.size(); j++) {
+        auto it = std::find(identifiers.begin(), identifiers.end(), jobs[j].identifier);
+        if (it == identifiers.end()) {
+            identifiers.push_back(jobs[j].identifier);
+            jobs_of.emplace_back();
+            it = identifiers.end() - 1;
         }
+        jobs_of[it - identifiers.begin()].push_back(j);
     }
 
-    // Thread-safe containers
-    std::vector<CDNCheckResult> results;
-    std::mutex results_mutex;
-    std::mutex console_mutex;
-    std::atomic<size_t> completed_count(0);
+    if (identifiers.size() == 1) {
+        std::cout << "\nTracking image: " << identifiers[0] << std::endl;
+        for (const auto& job : jobs) {
+            std::cout << "Target URL: " << job.url << std::endl;
+        }
+    } else {
+        std::cout << "\nTracking " << identifiers.size() << " images (" << jobs.size() << " URLs) in one pass" << std::endl;
+        for (const auto& job : jobs) {
+            std::cout << "  " << std::left << std::setw(20) << job.identifier << " " << job.url << std::endl;
+        }
+    }
 
-    // Worker function for each thread
-    auto worker = [&](size_t start_idx, size_t end_idx) {
-        HTTPClient thread_http_client;
-        thread_http_client.setTimeout(timeout_seconds_);
-
-        for (size_t i = start_idx; i < end_idx && i < all_ips.size(); i++) {
-            const std::string& ip_address = all_ips[i];
-
-            CDNCheckResult result;
-            result.ip_address = ip_address;
-            result.ip_range = "";
-
-            // Replace domain with IP in URL
-            std::string test_url = url_to_check;
-            size_t domain_start = test_url.find("://");
-            if (domain_start != std::string::npos) {
-                domain_start += 3;
-                size_t domain_end = test_url.find('/', domain_start);
-                if (domain_end != std::string::npos) {
-                    test_url = test_url.substr(0, domain_start) +
-                              ip_address +
-                              test_url.substr(domain_end);
-                } else {
-                    test_url = test_url.substr(0, domain_start) + ip_address;
-                }
-            }
+    std::unique_ptr<ColoSelector> colo_selector;
+    IPRangeList all_ips = selectTrackTargets(colo_selector);
 
-            // Make request
-            HTTPResponse response = thread_http_client.head(test_url, domain);
+    std::cout << "Checking " << all_ips.size() << " Cloudflare CDN IPs";
+    displayConcurrency(num_threads);
 
-            result.status_code = response.status_code;
-            result.is_hit = response.is_cache_hit;
-            result.cache_status = response.cf_cache_status;
-            result.cf_ray = response.cf_ray;
-            result.cf_iata_code = response.cf_iata_code;
-            result.cf_ip_country = response.cf_ip_country;
+    // Several URLs per edge: multiplex them as HTTP/2 streams over one connection
+    bool multiplex = jobs.size() > 1;
+    if (multiplex && useProbeEngine()) {
+        std::cout << "Multiplexing " << jobs.size()
+                  << " URLs per edge over a single HTTP/2 connection\n" << std::endl;
+    }
 
-            if (!response.success) {
-                result.error_message = response.error_message;
-            }
+    // Parse every URL once; probes only carry the edge IP and a target pointer
+    std::vector<ProbeTarget> targets;
+    for (const auto& job : jobs) {
+        targets.push_back(ProbeTarget::fromURL(job.url, pin_connect_, target_domain_));
+    }
+    if (pin_connect_) {
+        std::cout << "Pinning connections with CONNECT_TO (SNI: " << targets[0].url_host << ")\n" << std::endl;
+    }
 
-            // Add result to results vector (thread-safe)
-            {
-                std::lock_guard<std::mutex> lock(results_mutex);
-                results.push_back(result);
-            }
+    size_t total_probes = all_ips.size() * targets.size();
 
-            // Display result if HIT or no error (thread-safe)
-            if (result.is_hit || result.error_message.empty()) {
-                std::lock_guard<std::mutex> lock(console_mutex);
-                std::cout << "\r" << std::string(60, ' ') << "\r";
-                displayResult(result);
-            }
+    // Owned by the result consumer thread
+    ResultStore results;
+    results.reserve(total_probes);
+    size_t completed_count = 0;
 
-            // Update progress
-            size_t current = ++completed_count;
-            if (current % 10 == 0 || current == all_ips.size()) {
-                std::lock_guard<std::mutex> lock(console_mutex);
-                displayProgress(current, all_ips.size());
-            }
+    auto build_requests = [&](const std::string& ip_address, std::vector<ProbeRequest>& requests) {
+        for (size_t u = 0; u < targets.size(); u++) {
+            ProbeRequest request;
+            request.ip_address = ip_address;
+            request.target = &targets[u];
+            request.url_index = u;
+            requests.push_back(std::move(request));
         }
     };
 
-    // Create thread pool
-    std::vector<std::thread> threads;
-    size_t ips_per_thread = (all_ips.size() + num_threads - 1) / num_threads;
+    // Workers only publish compact events; the consumer thread stores the
+    // results and does all console output
+    if (result_sink_) {
+        result_sink_->begin(jobs);
+    }
+    std::string title = identifiers.size() == 1 ? "Tracking " + identifiers[0]
+                                                : "Tracking " + std::to_string(identifiers.size()) + " images";
+    if (dashboard_) {
+        dashboard_->begin(jobs, total_probes, title);
+    }
+    bool use_dashboard = dashboard_ && dashboard_->active();
 
-    for (size_t t = 0; t < num_threads; t++) {
-        size_t start_idx = t * ips_per_thread;
-        size_t end_idx = std::min(start_idx + ips_per_thread, all_ips.size());
+    auto on_event = [&](const ResultEvent& event) {
+        results.add(event);
+        size_t index = results.size() - 1;
+        if (result_sink_) {
+            result_sink_->write(event);
+        }
+        if (use_dashboard) {
+            dashboard_->add(event);
+            return;
+        }
 
-        if (start_idx < all_ips.size()) {
-            threads.emplace_back(worker, start_idx, end_idx);
+        // Display result if HIT or no error
+        if (results.isHit(index) || !results.isError(index)) {
+            std::cout << "\r" << std::string(60, ' ') << "\r";
+            displayResult(results, index);
         }
-    }
 
-    // Wait for all threads to complete
-    for (auto& thread : threads) {
-        thread.join();
+        // Update progress
+        size_t current = ++completed_count;
+        if (current % 10 == 0 || current == total_probes) {
+            displayProgress(current, total_probes);
+        }
+    };
+
+    // Representatives that errored are replaced by standbys of the same colo
+    // in further rounds until every colo is covered or out of IPs
+    IPRangeList round_ips = std::move(all_ips);
+    while (!round_ips.empty()) {
+        size_t first_result = results.size();
+        {
+            ResultPipeline pipeline(on_event, []() { std::cout.flush(); });
+            auto on_result = [&](const ProbeRequest& request, const HTTPResponse& response) {
+                pipeline.publish(ResultEvent::fromProbe(request, response));
+            };
+            runProbes(round_ips, build_requests, on_result, num_threads, multiplex);
+        }
+
+        if (!colo_selector) {
+            break;
+        }
+        round_ips = colo_selector->failover(results, first_result);
+        if (!round_ips.empty()) {
+            total_probes += round_ips.size() * targets.size();
+            if (use_dashboard) {
+                dashboard_->addExpected(round_ips.size() * targets.size());
+            }
+            std::cout << "\r" << std::string(60, ' ') << "\r";
+            std::cout << "Failing over to " << round_ips.size() << " standby IPs ("
+                      << colo_selector->standbyCount() << " left)" << std::endl;
+        }
+    }
+    if (use_dashboard) {
+        dashboard_->end();
     }
 
     std::cout << "\r" << std::string(60, ' ') << "\r"; // Clear progress line
     std::cout << "\nScan complete!\n";
 
-    // Display results in ASCII table
-    displayResultsTable(results);
+    if (jobs.size() == 1) {
+        // Display results in ASCII table
+        displayResults(results);
+        return;
+    }
+
+    // One table per URL, grouped by image
+    for (size_t i = 0; i < identifiers.size(); i++) {
+        if (identifiers.size() > 1) {
+            std::cout << "\n" << std::string(50, '=') << "\nImage: " << identifiers[i] << "\n" << std::string(50, '=');
+        }
+        for (size_t u : jobs_of[i]) {
+            std::cout << "\nURL: " << jobs[u].url;
+            displayResults(results, static_cast<int>(u));
+        }
+    }
+}
+
+static std::string formatTimestamp(time_t when) {
+    char timestamp[32];
+    strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", localtime(&when));
+    return timestamp;
+}
+
+void CDNTracker::watch(const std::vector<TrackJob>& jobs, const WatchOptions& options, size_t num_threads) {
+    if (!use_specific_ips_ && ip_ranges_.empty()) {
+        std::cerr << "No IP ranges loaded. Use loadIPRanges() first." << std::endl;
+        return;
+    }
+    if (jobs.empty() || jobs.size() > UINT16_MAX) {
+        std::cerr << "Watch needs between 1 and " << UINT16_MAX << " URLs." << std::endl;
+        return;
+    }
+
+    std::unique_ptr<ColoSelector> colo_selector;
+    IPRangeList all_ips = selectTrackTargets(colo_selector);
+    if (all_ips.empty()) {
+        std::cerr << "No IPs to watch." << std::endl;
+        return;
+    }
+
+    std::ofstream log;
+    if (!options.log_file.empty()) {
+        log.open(options.log_file, std::ios::app);
+        if (!log.is_open()) {
+            std::cerr << "Failed to open transitions log: " << options.log_file << std::endl;
+            return;
+        }
+    }
+
+    // Label transitions by identifier, adding the URL when an identifier has several
+    std::vector<std::string> labels;
+    for (const auto& job : jobs) {
+        size_t same = std::count_if(jobs.begin(), jobs.end(),
+                                    [&](const TrackJob& other) { return other.identifier == job.identifier; });
+        labels.push_back(same > 1 ? job.identifier + " " + job.url : job.identifier);
+    }
+
+    std::vector<ProbeTarget> targets;
+    for (const auto& job : jobs) {
+        targets.push_back(ProbeTarget::fromURL(job.url, pin_connect_, target_domain_));
+    }
+    bool multiplex = jobs.size() > 1;
+
+    // Per edge: its address and re-probe interval; per edge and URL: last cache status
+    size_t edge_count = all_ips.size();
+    std::vector<uint32_t> edge_ips(edge_count);
+    std::unordered_map<uint32_t, uint32_t> edge_of;
+    for (size_t e = 0; e < edge_count; e++) {
+        edge_ips[e] = all_ips.at(e);
+        edge_of[edge_ips[e]] = static_cast<uint32_t>(e);
+    }
+    uint64_t interval_ms = std::max<uint64_t>(options.interval_s, 1) * 1000;
+    uint64_t max_interval_ms = std::max<uint64_t>(options.max_interval_s * 1000ULL, interval_ms);
+    std::vector<uint64_t> edge_interval(edge_count, interval_ms);
+    std::vector<CacheStatus> status(edge_count * jobs.size(), CacheStatus::NONE);
+    std::vector<uint8_t> edge_all_hit(edge_count, 0);
+    std::vector<uint8_t> edge_answered(edge_count, 0);
+
+    std::cout << "Watching " << edge_count << " edges x " << jobs.size() << " URLs every "
+              << options.interval_s << "s (HIT edges back off to " << max_interval_ms / 1000 << "s)";
+    if (options.duration_s > 0) {
+        std::cout << " for " << options.duration_s << "s";
+    }
+    std::cout << ", Ctrl+C to stop\n" << std::endl;
+
+    auto clock_ms = []() {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    };
+    uint64_t start_ms = clock_ms();
+
+    // Everything is probed once for the baseline, then per edge on its own cadence
+    TimerWheel wheel(250, 4096, start_ms);
+    for (size_t e = 0; e < edge_count; e++) {
+        wheel.schedule(static_cast<uint32_t>(e), start_ms);
+    }
+
+    size_t rounds = 0;
+    size_t probes = 0;
+    size_t transitions = 0;
+    size_t hits = 0;  // Edge/URL pairs currently HIT
+
+    // Only changes of a known cache status are reported; errors keep the old status
+    if (result_sink_) {
+        result_sink_->begin(jobs);
+    }
+    auto on_event = [&](const ResultEvent& event) {
+        probes++;
+        if (result_sink_) {
+            result_sink_->write(event);
+        }
+        uint32_t edge = edge_of[event.ip];
+        if (!event.success) {
+            edge_all_hit[edge] = 0;
+            return;
+        }
+        edge_answered[edge] = 1;
+
+        CacheStatus now_status = ResultStore::parseCacheStatus(event.headers.cache_status);
+        if (now_status != CacheStatus::HIT) {
+            edge_all_hit[edge] = 0;
+        }
+        CacheStatus& last = status[edge * jobs.size() + event.url_index];
+        if (now_status == last) {
+            return;
+        }
+        hits += (now_status == CacheStatus::HIT) - (last == CacheStatus::HIT);
+        CacheStatus previous = last;
+        last = now_status;
+        if (previous == CacheStatus::NONE) {
+            return;  // Baseline
+        }
+
+        transitions++;
+        time_t when = time(nullptr);
+        std::string ip = CIDRUtils::uint32ToIp(event.ip);
+        std::string iata = event.headers.iata_code[0] ? event.headers.iata_code : "-";
+        std::string from = ResultStore::cacheStatusName(previous);
+        std::string to = now_status == CacheStatus::NONE ? "-" : ResultStore::cacheStatusName(now_status);
+        const char* color = now_status == CacheStatus::HIT ? "\033[32m" : "\033[33m";
+
+        std::cout << "\r" << std::string(70, ' ') << "\r";
+        std::cout << formatTimestamp(when) << "  " << std::left << std::setw(16) << ip << " "
+                  << std::setw(4) << iata << " " << color << from << " -> " << to << "\033[0m  "
+                  << labels[event.url_index] << '\n';
+        if (log.is_open()) {
+            log << formatTimestamp(when) << '\t' << when << '\t' << jobs[event.url_index].identifier << '\t'
+                << jobs[event.url_index].url << '\t' << ip << '\t' << iata << '\t' << from << '\t' << to << '\n';
+        }
+    };
+
+    auto build_requests = [&](const std::string& ip_address, std::vector<ProbeRequest>& requests) {
+        for (size_t u = 0; u < targets.size(); u++) {
+            ProbeRequest request;
+            request.ip_address = ip_address;
+            request.target = &targets[u];
+            request.url_index = u;
+            requests.push_back(std::move(request));
+        }
+    };
+
+    scan_interrupted.store(false);
+    auto previous_int = std::signal(SIGINT, onScanSignal);
+    auto previous_term = std::signal(SIGTERM, onScanSignal);
+
+    std::vector<uint32_t> due;
+    while (!scan_interrupted.load()) {
+        uint64_t now_ms = clock_ms();
+        if (options.duration_s > 0 && now_ms - start_ms >= options.duration_s * 1000ULL) {
+            break;
+        }
+
+        due.clear();
+        wheel.advance(now_ms, due);
+        if (due.empty()) {
+            uint64_t next_ms = wheel.nextTickMs();
+            std::this_thread::sleep_for(std::chrono::milliseconds(next_ms > now_ms ? next_ms - now_ms : 1));
+            continue;
+        }
+
+        IPRangeList round_ips;
+        for (uint32_t edge : due) {
+            round_ips.addAddress(edge_ips[edge]);
+            edge_all_hit[edge] = 1;
+            edge_answered[edge] = 0;
+        }
+        {
+            ResultPipeline pipeline(on_event, []() { std::cout.flush(); });
+            auto on_result = [&](const ProbeRequest& request, const HTTPResponse& response) {
+                pipeline.publish(ResultEvent::fromProbe(request, response));
+            };
+            runProbes(round_ips, build_requests, on_result, num_threads, multiplex);
+        }
+        rounds++;
+
+        // Rounds are minutes apart; don't keep their results in the buffer
+        if (result_sink_) {
+            result_sink_->flush();
+        }
+
+        // Edges that are HIT for every URL back off; anything else returns to the cadence
+        uint64_t done_ms = clock_ms();
+        for (uint32_t edge : due) {
+            if (edge_all_hit[edge] && edge_answered[edge]) {
+                edge_interval[edge] = std::min(edge_interval[edge] * 2, max_interval_ms);
+            } else {
+                edge_interval[edge] = interval_ms;
+            }
+            wheel.schedule(edge, done_ms + edge_interval[edge]);
+        }
+
+        std::cout << "\r" << std::string(70, ' ') << "\r"
+                  << "[" << formatTimestamp(time(nullptr)) << "] " << hits << "/" << status.size()
+                  << " HIT, " << transitions << " transitions, " << probes << " probes" << std::flush;
+    }
+
+    std::signal(SIGINT, previous_int);
+    std::signal(SIGTERM, previous_term);
+    scan_interrupted.store(false);
+
+    // Compare with probing everything at the base cadence
+    uint64_t elapsed_ms = clock_ms() - start_ms;
+    size_t fixed_probes = status.size() * static_cast<size_t>(elapsed_ms / interval_ms + 1);
+    std::cout << "\r" << std::string(70, ' ') << "\r";
+    std::cout << "\nWatch stopped after " << elapsed_ms / 1000 << "s: " << rounds << " rounds, "
+              << probes << " probes (" << fixed_probes << " at a fixed " << options.interval_s << "s cadence), "
+              << transitions << " transitions" << std::endl;
+    if (log.is_open()) {
+        std::cout << "Transitions logged to: " << options.log_file << std::endl;
+    }
 }
 
 } // namespace cfpinner
@@ -12,7 +12,7 @@
 
 namespace cfpinner {
 
-CDNUpdater::CDNUpdater() {
+CDNUpdater::CDNUpdater() : alive_ttl_(7 * 86400) {
     // Get home directory
     const char* home = getenv("HOME");
     if (!home) {
@@ -23,6 +23,8 @@ CDNUpdater::CDNUpdater() {
     config_dir_ = std::string(home) + "/.cfpinner";
     ip_ranges_file_ = config_dir_ + "/cf_cdn_ips.txt";
     alive_ips_file_ = config_dir_ + "/alive_ips.txt";
+    alive_index_file_ = config_dir_ + "/alive_ips.idx";
+    checkpoint_file_ = config_dir_ + "/alive_scan.ckpt";
 
     // Ensure config directory exists
     struct stat st;
@@ -62,6 +64,9 @@ int CDNUpdater::getFileAgeDays() const {
 }
 
 int CDNUpdater::getAliveIPsAgeDays() const {
+    if (fileExists(alive_index_file_)) {
+        return getFileAge(alive_index_file_);
+    }
     return getFileAge(alive_ips_file_);
 }
 
@@ -79,66 +84,56 @@ std::string CDNUpdater::getIPRangesFilePath() const {
 }
 
 std::string CDNUpdater::getAliveIPsFilePath() const {
+    return alive_index_file_;
+}
+
+std::string CDNUpdater::getAliveIPsTextPath() const {
     return alive_ips_file_;
 }
 
-bool CDNUpdater::hasRecentAliveIPs() const {
-    int age = getAliveIPsAgeDays();
-    return (age >= 0 && age < 7); // Consider alive IPs recent if less than 7 days old
+std::string CDNUpdater::getCheckpointFilePath() const {
+    return checkpoint_file_;
 }
 
-bool CDNUpdater::saveAliveIPs(const std::vector<std::string>& alive_ips) {
-    std::ofstream file(alive_ips_file_);
-    if (!file.is_open()) {
-        std::cerr << "Failed to save alive IPs to: " << alive_ips_file_ << std::endl;
+bool CDNUpdater::hasRecentAliveIPs() const {
+    // Each IP expires on its own, TTL after it last answered
+    AliveIndex index;
+    if (!index.open(alive_index_file_) && !index.importText(alive_ips_file_)) {
         return false;
     }
+    return index.freshCount(alive_ttl_) > 0;
+}
 
-    // Write header
-    file << "# Cloudflare CDN Alive IPs" << std::endl;
-    file << "# IPs that responded with HIT or MISS status" << std::endl;
+void CDNUpdater::setAliveTTL(uint32_t ttl_seconds) {
+    alive_ttl_ = ttl_seconds;
+}
 
-    time_t now = time(nullptr);
-    char timestamp[100];
-    strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", localtime(&now));
-    file << "# Scanned: " << timestamp << std::endl;
-    file << "# Total alive: " << alive_ips.size() << std::endl;
-    file << std::endl;
+bool CDNUpdater::saveAliveIPs(const std::vector<AliveRecord>& alive_records) {
+    return AliveIndex::write(alive_index_file_, alive_records);
+}
 
-    // Write IP addresses
-    for (const auto& ip : alive_ips) {
-        file << ip << std::endl;
+bool CDNUpdater::loadAliveIPs(AliveIndex& index) {
+    if (index.open(alive_index_file_)) {
+        return !index.empty();
     }
 
-    file.close();
-    return true;
+    // Lists saved before the binary index existed
+    return index.importText(alive_ips_file_);
 }
 
-bool CDNUpdater::loadAliveIPs(std::vector<std::string>& alive_ips) {
-    std::ifstream file(alive_ips_file_);
-    if (!file.is_open()) {
+bool CDNUpdater::exportAliveIPs(const std::string& path) {
+    AliveIndex index;
+    if (!loadAliveIPs(index)) {
+        std::cerr << "No alive IPs to export. Run 'cfpinner --alive' first." << std::endl;
         return false;
     }
 
-    alive_ips.clear();
-    std::string line;
-    while (std::getline(file, line)) {
-        // Skip comments and empty lines
-        if (line.empty() || line[0] == '#') {
-            continue;
-        }
-
-        // Trim whitespace
-        line.erase(0, line.find_first_not_of(" \t\r\n"));
-        line.erase(line.find_last_not_of(" \t\r\n") + 1);
-
-        if (!line.empty()) {
-            alive_ips.push_back(line);
-        }
+    std::string export_path = path.empty() ? alive_ips_file_ : path;
+    if (!index.exportText(export_path)) {
+        return false;
     }
-
-    file.close();
-    return !alive_ips.empty();
+    std::cout << "Exported " << index.size() << " alive IPs to: " << export_path << std::endl;
+    return true;
 }
 
 bool CDNUpdater::downloadIPRanges(std::vector<std::string>& ipv4_ranges) {
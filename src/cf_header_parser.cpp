@@ -0,0 +1,152 @@
+#include "cf_header_parser.h"
+#include "http_client.h"
+#include <cstring>
+#include <strings.h>
+
+namespace cfpinner {
+
+namespace {
+
+struct HeaderKeyword {
+    const char* name;  // Lowercase header name
+    uint8_t length;
+    CFHeaderParser::Field field;
+};
+
+// Headers we capture; every name starts with "cf-" which makes a cheap prefilter
+constexpr HeaderKeyword kKeywords[] = {
+    {"cf-cache-status", 15, CFHeaderParser::FIELD_CACHE_STATUS},
+    {"cf-ray",           6, CFHeaderParser::FIELD_RAY},
+    {"cf-ipcountry",    12, CFHeaderParser::FIELD_IP_COUNTRY},
+};
+
+constexpr size_t kMaxKeywordLength = 15;
+
+inline char toLowerAscii(char c) {
+    return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+// Copy a header value into a fixed buffer, truncating if needed
+template <size_t N>
+void copyValue(char (&dest)[N], const char* value, size_t length) {
+    size_t n = length < N - 1 ? length : N - 1;
+    std::memcpy(dest, value, n);
+    dest[n] = '\0';
+}
+
+} // namespace
+
+CFHeaderParser::CFHeaderParser() {
+    reset();
+}
+
+void CFHeaderParser::reset() {
+    headers_.cache_status[0] = '\0';
+    headers_.ray[0] = '\0';
+    headers_.iata_code[0] = '\0';
+    headers_.ip_country[0] = '\0';
+    found_ = 0;
+}
+
+void CFHeaderParser::feedLine(const char* line, size_t length) {
+    // Status line of a new response (e.g. after a redirect)
+    if (length >= 5 && std::memcmp(line, "HTTP/", 5) == 0) {
+        reset();
+        return;
+    }
+
+    if (complete()) {
+        return;
+    }
+
+    // Prefilter: all wanted headers start with "cf-"
+    if (length < 4 || toLowerAscii(line[0]) != 'c' || toLowerAscii(line[1]) != 'f' || line[2] != '-') {
+        return;
+    }
+
+    const char* colon = static_cast<const char*>(std::memchr(line, ':', length));
+    if (!colon) {
+        return;
+    }
+    size_t name_length = static_cast<size_t>(colon - line);
+    if (name_length > kMaxKeywordLength) {
+        return;
+    }
+
+    const HeaderKeyword* match = nullptr;
+    for (const auto& keyword : kKeywords) {
+        if (keyword.length != name_length) {
+            continue;
+        }
+        size_t i = 3; // "cf-" already matched
+        while (i < name_length && toLowerAscii(line[i]) == keyword.name[i]) {
+            i++;
+        }
+        if (i == name_length) {
+            match = &keyword;
+            break;
+        }
+    }
+    if (!match) {
+        return;
+    }
+
+    // Trim whitespace around the value, including the trailing CRLF
+    const char* value = colon + 1;
+    const char* end = line + length;
+    while (value < end && (*value == ' ' || *value == '\t')) {
+        value++;
+    }
+    while (end > value && (end[-1] == '\r' || end[-1] == '\n' || end[-1] == ' ' || end[-1] == '\t')) {
+        end--;
+    }
+    size_t value_length = static_cast<size_t>(end - value);
+
+    switch (match->field) {
+        case FIELD_CACHE_STATUS:
+            copyValue(headers_.cache_status, value, value_length);
+            break;
+        case FIELD_RAY: {
+            copyValue(headers_.ray, value, value_length);
+
+            // Extract IATA code (3 characters after the last dash)
+            // Format: "8428f15b8a9c1234-SJC"
+            const char* dash = end;
+            while (dash > value && dash[-1] != '-') {
+                dash--;
+            }
+            if (dash > value && end - dash >= 3) {
+                copyValue(headers_.iata_code, dash, 3);
+            }
+            break;
+        }
+        case FIELD_IP_COUNTRY:
+            copyValue(headers_.ip_country, value, value_length);
+            break;
+        default:
+            break;
+    }
+    found_ |= match->field;
+}
+
+void CFHeaderParser::apply(HTTPResponse& response) const {
+    if (found_ & FIELD_CACHE_STATUS) {
+        response.cf_cache_status.assign(headers_.cache_status);
+        response.is_cache_hit = (strcasecmp(headers_.cache_status, "HIT") == 0);
+    }
+    if (found_ & FIELD_RAY) {
+        response.cf_ray.assign(headers_.ray);
+        response.cf_iata_code.assign(headers_.iata_code);
+    }
+    if (found_ & FIELD_IP_COUNTRY) {
+        response.cf_ip_country.assign(headers_.ip_country);
+    }
+}
+
+size_t CFHeaderParser::curlCallback(char* buffer, size_t size, size_t nitems, void* userdata) {
+    size_t total_size = size * nitems;
+    static_cast<CFHeaderParser*>(userdata)->feedLine(buffer, total_size);
+    return total_size;
+}
+
+} // namespace cfpinner
@@ -3,7 +3,17 @@
 #include "cdn_tracker.h"
 #include "cdn_updater.h"
 #include "config.h"
+#include "metrics_exporter.h"
+#include "result_sink.h"
+#include "dashboard.h"
+#include "shard_merge.h"
 #include <iostream>
+#include <fstream>
+#include <sstream>
+#include <memory>
+#include <cstdio>
+#include <cstdint>
+#include <algorithm>
 
 namespace cfpinner {
 
@@ -13,6 +23,54 @@ Application::Application() {
 Application::~Application() {
 }
 
+// Open the --output sink, if one was requested; false if it can't be created
+static bool openResultSink(const ScanOptions& options, std::unique_ptr<ResultSink>& sink) {
+    if (options.output_file.empty()) {
+        return true;
+    }
+
+    ResultSink::Format format = ResultSink::formatForPath(options.output_file);
+    if (!options.output_format.empty() && !ResultSink::parseFormat(options.output_format, format)) {
+        std::cerr << "Error: Unknown output format: " << options.output_format
+                  << " (use ndjson, csv or binary)" << std::endl;
+        return false;
+    }
+    sink = ResultSink::open(format, options.output_file);
+    return sink != nullptr;
+}
+
+// Parse "i/N" with 1 <= i <= N. Only digits are accepted: stoul would take
+// a leading minus sign and wrap it around.
+static bool parseShard(const std::string& value, size_t& index, size_t& count) {
+    size_t slash = value.find('/');
+    if (slash == std::string::npos || value.find_first_not_of("0123456789/") != std::string::npos) {
+        return false;
+    }
+    std::string index_text = value.substr(0, slash);
+    std::string count_text = value.substr(slash + 1);
+    if (index_text.empty() || count_text.empty() || count_text.find('/') != std::string::npos ||
+        index_text.size() > 9 || count_text.size() > 9) {
+        return false;
+    }
+    index = std::stoul(index_text);
+    count = std::stoul(count_text);
+    return index >= 1 && index <= count;
+}
+
+// Flush the rest of the results and report where they went
+static bool closeResultSink(std::unique_ptr<ResultSink>& sink) {
+    if (!sink) {
+        return true;
+    }
+    if (!sink->close()) {
+        std::cerr << "Error: Failed to write results to " << sink->path() << std::endl;
+        return false;
+    }
+    std::cout << "Wrote " << sink->count() << " results to "
+              << (sink->path() == "-" ? "stdout" : sink->path()) << std::endl;
+    return true;
+}
+
 void Application::printBanner() const {
     std::cout << "\033[36m" << std::endl;
     std::cout << "  ____ _____ ____  _                       " << std::endl;
@@ -25,6 +83,15 @@ void Application::printBanner() const {
 }
 
 int Application::run(int argc, char* argv[]) {
+    // With results streamed to stdout, everything else goes to stderr
+    for (int i = 2; i + 1 < argc; i++) {
+        std::string arg = argv[i];
+        if ((arg == "--output" || arg == "-o") && std::string(argv[i + 1]) == "-") {
+            std::cout.rdbuf(std::cerr.rdbuf());
+            break;
+        }
+    }
+
     printBanner();
 
     if (argc < 2) {
@@ -35,19 +102,114 @@ int Application::run(int argc, char* argv[]) {
     std::string command = argv[1];
 
     // Parse global options
-    int timeout = -1; // -1 means use default
-    bool force_all = false;
-    size_t num_threads = 10; // Default number of threads
+    ScanOptions options;
 
     for (int i = 2; i < argc; i++) {
         std::string arg = argv[i];
         if (arg == "--timeout-overrule" && i + 1 < argc) {
-            timeout = std::stoi(argv[i + 1]);
+            options.timeout = std::stoi(argv[i + 1]);
             i++; // Skip next arg
         } else if (arg == "--force-all") {
-            force_all = true;
+            options.force_all = true;
+        } else if (arg == "--shard" && i + 1 < argc) {
+            size_t index = 0;
+            size_t count = 0;
+            if (!parseShard(argv[i + 1], index, count)) {
+                std::cerr << "Error: --shard expects i/N with 1 <= i <= N (e.g. --shard 2/4)" << std::endl;
+                return 1;
+            }
+            options.shard_index = index - 1;
+            options.shard_count = count;
+            i++; // Skip next arg
         } else if ((arg == "--threads" || arg == "--num-threads") && i + 1 < argc) {
-            num_threads = std::stoul(argv[i + 1]);
+            options.num_threads = std::stoul(argv[i + 1]);
+            i++; // Skip next arg
+        } else if (arg == "--retries" && i + 1 < argc) {
+            options.retries = static_cast<unsigned>(std::stoul(argv[i + 1]));
+            i++; // Skip next arg
+        } else if (arg == "--retry-budget" && i + 1 < argc) {
+            options.retry_budget = std::stod(argv[i + 1]);
+            i++; // Skip next arg
+        } else if (arg == "--adaptive-concurrency") {
+            options.adaptive_concurrency = true;
+        } else if (arg == "--max-inflight" && i + 1 < argc) {
+            options.max_in_flight = std::stoul(argv[i + 1]);
+            i++; // Skip next arg
+        } else if (arg == "--url" && i + 1 < argc) {
+            options.extra_urls.push_back(argv[i + 1]);
+            i++; // Skip next arg
+        } else if (arg == "--per-colo" && i + 1 < argc) {
+            options.per_colo = std::stoul(argv[i + 1]);
+            i++; // Skip next arg
+        } else if (arg == "--tui") {
+            options.tui = true;
+        } else if (arg == "--table") {
+            options.show_table = true;
+        } else if (arg == "--refresh") {
+            options.refresh = true;
+        } else if (arg == "--ttl-hours" && i + 1 < argc) {
+            double hours = std::stod(argv[i + 1]);
+            if (!(hours >= 0)) {
+                std::cerr << "Error: --ttl-hours must be 0 (never expire) or more" << std::endl;
+                return 1;
+            }
+            // The TTL is kept in 32-bit seconds
+            options.ttl_hours = std::min(hours, static_cast<double>(UINT32_MAX / 3600));
+            i++; // Skip next arg
+        } else if (arg == "--dead-sample" && i + 1 < argc) {
+            options.dead_sample = std::stoul(argv[i + 1]);
+            i++; // Skip next arg
+        } else if (arg == "--resume") {
+            options.resume = true;
+            options.checkpoint = true;
+        } else if (arg == "--checkpoint-interval" && i + 1 < argc) {
+            options.checkpoint_interval = static_cast<unsigned>(std::stoul(argv[i + 1]));
+            options.checkpoint = true;
+            i++; // Skip next arg
+        } else if (arg == "--watch") {
+            options.watch = true;
+        } else if (arg == "--watch-interval" && i + 1 < argc) {
+            options.watch_interval = static_cast<unsigned>(std::stoul(argv[i + 1]));
+            i++; // Skip next arg
+        } else if (arg == "--watch-max-interval" && i + 1 < argc) {
+            options.watch_max_interval = static_cast<unsigned>(std::stoul(argv[i + 1]));
+            i++; // Skip next arg
+        } else if (arg == "--watch-duration" && i + 1 < argc) {
+            options.watch_duration = static_cast<unsigned>(std::stoul(argv[i + 1]));
+            i++; // Skip next arg
+        } else if (arg == "--watch-log" && i + 1 < argc) {
+            options.watch_log = argv[i + 1];
+            i++; // Skip next arg
+        } else if (arg == "--metrics-dir" && i + 1 < argc) {
+            options.metrics_dir = argv[i + 1];
+            i++; // Skip next arg
+        } else if (arg == "--metrics-interval" && i + 1 < argc) {
+            options.metrics_interval = static_cast<unsigned>(std::stoul(argv[i + 1]));
+            i++; // Skip next arg
+        } else if ((arg == "--output" || arg == "-o") && i + 1 < argc) {
+            options.output_file = argv[i + 1];
+            i++; // Skip next arg
+        } else if (arg == "--output-format" && i + 1 < argc) {
+            options.output_format = argv[i + 1];
+            i++; // Skip next arg
+        } else if (arg == "--pin-connect") {
+            options.pin_connect = true;
+        } else if (arg == "--connect-scan") {
+            options.connect_scan = true;
+        } else if (arg == "--connect-timeout-ms" && i + 1 < argc) {
+            options.connect_timeout_ms = std::stol(argv[i + 1]);
+            i++; // Skip next arg
+        } else if (arg == "--timeout-ms" && i + 1 < argc) {
+            options.timeout_ms = std::stol(argv[i + 1]);
+            i++; // Skip next arg
+        } else if (arg == "--adaptive-timeout") {
+            options.adaptive_timeout = true;
+        } else if (arg == "--rtt-multiplier" && i + 1 < argc) {
+            options.rtt_multiplier = std::stod(argv[i + 1]);
+            if (!(options.rtt_multiplier > 0)) {
+                std::cerr << "Error: --rtt-multiplier must be greater than 0" << std::endl;
+                return 1;
+            }
             i++; // Skip next arg
         }
     }
@@ -74,13 +236,46 @@ int Application::run(int argc, char* argv[]) {
         }
         std::string identifier = argv[2];
         std::string url = argv[3];
-        int track_timeout = (timeout == -1) ? 5 : timeout;
-        return handleTrack(identifier, url, track_timeout, force_all, num_threads);
+        if (options.timeout == -1) {
+            options.timeout = 5;
+        }
+        return handleTrack(identifier, url, options);
     } else if (command == "--update-cdn" || command == "-u") {
         return handleUpdateCDN();
     } else if (command == "--alive" || command == "-a") {
-        int alive_timeout = (timeout == -1) ? 1 : timeout;
-        return handleAlive(alive_timeout, force_all, num_threads);
+        if (options.timeout == -1) {
+            options.timeout = 1;
+        }
+        return handleAlive(options);
+    } else if (command == "--batch" || command == "-b") {
+        if (argc < 3) {
+            std::cerr << "Error: --batch requires a job file" << std::endl;
+            std::cerr << "Example: cfpinner --batch jobs.txt" << std::endl;
+            return 1;
+        }
+        if (options.timeout == -1) {
+            options.timeout = 5;
+        }
+        return handleBatch(argv[2], options);
+    } else if (command == "--export-alive") {
+        // Optional output file; a following option is not a path
+        std::string output_file = "";
+        if (argc > 2 && argv[2][0] != '-') {
+            output_file = argv[2];
+        }
+        return handleExportAlive(output_file);
+    } else if (command == "--merge") {
+        // Output, then the inputs; options that follow are not inputs
+        std::vector<std::string> inputs;
+        for (int i = 3; i < argc && argv[i][0] != '-'; i++) {
+            inputs.push_back(argv[i]);
+        }
+        if (argc < 3 || argv[2][0] == '-' || inputs.empty()) {
+            std::cerr << "Error: --merge requires an output file and at least one input" << std::endl;
+            std::cerr << "Example: cfpinner --merge alive_ips.idx shard1.idx shard2.idx" << std::endl;
+            return 1;
+        }
+        return handleMerge(argv[2], inputs);
     } else {
         std::cerr << "Unknown command: " << command << std::endl;
         printUsage();
@@ -94,17 +289,75 @@ void Application::printUsage() const {
     std::cout << "  -g, --generate [--save <dir>]   Generate a unique PNG image" << std::endl;
     std::cout << "  -a, --alive [options]           Scan and cache alive CDN nodes (multi-threaded)" << std::endl;
     std::cout << "  -t, --track <id> <url> [opts]   Track image across Cloudflare CDN" << std::endl;
+    std::cout << "  -b, --batch <file> [opts]       Track many images in one pass; <file> has one" << std::endl;
+    std::cout << "                                  \"<id> <url>\" pair per line" << std::endl;
     std::cout << "  -u, --update-cdn                Update Cloudflare IP ranges" << std::endl;
+    std::cout << "  --export-alive [file]           Export the alive IPs index as text" << std::endl;
+    std::cout << "                                  (default: ~/.cfpinner/alive_ips.txt)" << std::endl;
+    std::cout << "  --merge <out> <in>...           Merge the outputs of --shard scans: alive lists" << std::endl;
+    std::cout << "                                  into an alive index, or binary result files" << std::endl;
     std::cout << "  -h, --help                      Show this help message" << std::endl;
     std::cout << "\nOptions:" << std::endl;
     std::cout << "  -s, --save <dir>                Custom output directory for generated image" << std::endl;
     std::cout << "                                  (default: ~/.cfpinner/images/)" << std::endl;
     std::cout << "  --threads <num>                 Number of parallel threads for scanning" << std::endl;
     std::cout << "                                  (default: 10)" << std::endl;
+    std::cout << "  --max-inflight <num>            Use the event-driven engine with up to <num>" << std::endl;
+    std::cout << "                                  concurrent probes instead of threads" << std::endl;
+    std::cout << "  --adaptive-concurrency          Use the event-driven engine and tune the in-flight" << std::endl;
+    std::cout << "                                  limit from error rate and latency (AIMD); the" << std::endl;
+    std::cout << "                                  --max-inflight value is the ceiling (default: 4096)" << std::endl;
+    std::cout << "  --retries <num>                 Retry timeouts/resets after the main pass, with" << std::endl;
+    std::cout << "                                  exponential backoff (default: 1, 0 disables)" << std::endl;
+    std::cout << "  --retry-budget <percent>        Cap on retries as a share of all probes (default: 10)" << std::endl;
+    std::cout << "  --url <url>                     (--track) Also check this URL, e.g. a resized" << std::endl;
+    std::cout << "                                  variant; repeatable, multiplexed over HTTP/2" << std::endl;
+    std::cout << "  --per-colo <num>                (--track) Probe only <num> alive IPs per colo, failing" << std::endl;
+    std::cout << "                                  over to another IP of the colo on errors" << std::endl;
+    std::cout << "  --tui                           (--alive, --track, --batch) Live full-screen dashboard:" << std::endl;
+    std::cout << "                                  scrollable results, per-colo counters, throughput" << std::endl;
+    std::cout << "  --table                         (--track) List every probed IP instead of the" << std::endl;
+    std::cout << "                                  per-colo summary" << std::endl;
+    std::cout << "  --pin-connect                   Keep the URL's hostname (correct SNI) and pin each" << std::endl;
+    std::cout << "                                  probe to the edge IP instead of rewriting the URL" << std::endl;
+    std::cout << "                                  (the TLS certificate is then verified)" << std::endl;
+    std::cout << "  --watch                         (--track, --batch) Keep probing and print cache" << std::endl;
+    std::cout << "                                  status transitions (e.g. MISS -> HIT) as they happen" << std::endl;
+    std::cout << "  --watch-interval <seconds>      Probe interval per edge (default: 60)" << std::endl;
+    std::cout << "  --watch-max-interval <seconds>  Edges that are HIT back off up to this (default: 960)" << std::endl;
+    std::cout << "  --watch-duration <seconds>      Stop watching after this long (default: until Ctrl+C)" << std::endl;
+    std::cout << "  --watch-log <file>              Append transitions as tab-separated lines" << std::endl;
+    std::cout << "  --refresh                       (--alive) Re-probe only cached IPs past their TTL" << std::endl;
+    std::cout << "                                  plus a rotating sample of uncached addresses" << std::endl;
+    std::cout << "  --ttl-hours <hours>             How long an alive IP stays cached" << std::endl;
+    std::cout << "                                  (default: 168, 0 = never expires)" << std::endl;
+    std::cout << "  --dead-sample <num>             (--refresh) Uncached addresses to probe (default: 256)" << std::endl;
+    std::cout << "  --resume                        (--alive) Continue an interrupted scan from its" << std::endl;
+    std::cout << "                                  checkpoint, skipping IPs already probed" << std::endl;
+    std::cout << "  --checkpoint-interval <seconds> How often scan progress is saved (default: 30);" << std::endl;
+    std::cout << "                                  --force-all scans are always checkpointed, sampled" << std::endl;
+    std::cout << "                                  ones only with this option or --resume" << std::endl;
+    std::cout << "  -o, --output <file>             Stream every result to <file> as it arrives" << std::endl;
+    std::cout << "                                  (\"-\" for stdout; other output moves to stderr)" << std::endl;
+    std::cout << "  --output-format <format>        ndjson, csv or binary (default: from the file" << std::endl;
+    std::cout << "                                  extension, else ndjson)" << std::endl;
+    std::cout << "  --metrics-dir <dir>             Write live scan metrics to <dir>/cfpinner.prom" << std::endl;
+    std::cout << "                                  (Prometheus textfile) and <dir>/cfpinner.json" << std::endl;
+    std::cout << "  --metrics-interval <seconds>    How often the metrics are written (default: 15)" << std::endl;
+    std::cout << "  --connect-scan                  (--alive) TCP connect to :443 first, HEAD-check" << std::endl;
+    std::cout << "                                  only the IPs that accept the connection" << std::endl;
+    std::cout << "  --connect-timeout-ms <ms>       TCP connect timeout for probes and --connect-scan" << std::endl;
+    std::cout << "                                  (default: 500 for --connect-scan, else unset)" << std::endl;
     std::cout << "  --timeout-overrule <seconds>    Override default timeout" << std::endl;
     std::cout << "                                  (default: 1s for --alive, 5s for --track)" << std::endl;
+    std::cout << "  --timeout-ms <ms>               Override default timeout in milliseconds" << std::endl;
+    std::cout << "  --adaptive-timeout              Set each probe's deadline from measured RTT" << std::endl;
+    std::cout << "                                  (timeout stays the ceiling)" << std::endl;
+    std::cout << "  --rtt-multiplier <x>            Deadline = x * observed p99 RTT (default: 4)" << std::endl;
     std::cout << "  --force-all                     Expand FULL CIDR ranges (no sampling)" << std::endl;
     std::cout << "                                  WARNING: May result in 500k+ IPs!" << std::endl;
+    std::cout << "  --shard <i>/<N>                 Probe only part i of N of the range addresses, so" << std::endl;
+    std::cout << "                                  N hosts can split a scan (--merge the outputs)" << std::endl;
     std::cout << "\nExamples:" << std::endl;
     std::cout << "  cfpinner --generate" << std::endl;
     std::cout << "  cfpinner --generate --save /tmp" << std::endl;
@@ -114,9 +367,25 @@ void Application::printUsage() const {
     std::cout << "  cfpinner --alive --threads 5" << std::endl;
     std::cout << "  cfpinner --alive --timeout-overrule 2" << std::endl;
     std::cout << "  cfpinner --alive --force-all --timeout-overrule 1" << std::endl;
+    std::cout << "  cfpinner --alive --force-all --max-inflight 5000" << std::endl;
+    std::cout << "  cfpinner --alive --force-all --connect-scan --connect-timeout-ms 300" << std::endl;
+    std::cout << "  cfpinner --alive --max-inflight 2000 --adaptive-timeout --timeout-ms 1500" << std::endl;
+    std::cout << "  cfpinner --alive --force-all --adaptive-concurrency" << std::endl;
+    std::cout << "  cfpinner --alive --refresh --ttl-hours 24" << std::endl;
+    std::cout << "  cfpinner --alive --force-all --max-inflight 5000 --resume" << std::endl;
+    std::cout << "  cfpinner --alive --force-all --max-inflight 5000 --shard 1/4" << std::endl;
+    std::cout << "  cfpinner --merge alive_ips.idx host1/alive_ips.idx host2/alive_ips.idx" << std::endl;
+    std::cout << "  cfpinner --alive --force-all --max-inflight 5000 --metrics-dir /var/lib/node_exporter" << std::endl;
     std::cout << "  cfpinner --track abc123def456 https://example.com/images/abc123def456.png" << std::endl;
     std::cout << "  cfpinner --track abc123def456 https://example.com/image.png --threads 20" << std::endl;
     std::cout << "  cfpinner --track abc123def456 https://example.com/image.png --force-all" << std::endl;
+    std::cout << "  cfpinner --track abc123def456 https://example.com/image.png --url https://example.com/thumb.png --max-inflight 500" << std::endl;
+    std::cout << "  cfpinner --track abc123def456 https://example.com/image.png --per-colo 2" << std::endl;
+    std::cout << "  cfpinner --batch jobs.txt --max-inflight 500" << std::endl;
+    std::cout << "  cfpinner --batch jobs.txt --output results.csv" << std::endl;
+    std::cout << "  cfpinner --alive --force-all --max-inflight 5000 --tui" << std::endl;
+    std::cout << "  cfpinner --track abc123def456 https://example.com/image.png --output - | jq ." << std::endl;
+    std::cout << "  cfpinner --track abc123def456 https://example.com/image.png --watch --watch-log timeline.tsv" << std::endl;
     std::cout << "\nWorkflow:" << std::endl;
     std::cout << "  1. (Optional) Run --alive to discover responsive CDN nodes (speeds up tracking)" << std::endl;
     std::cout << "  2. Generate a unique image with --generate" << std::endl;
@@ -124,7 +393,7 @@ void Application::printUsage() const {
     std::cout << "  4. Track the image with --track to see which CDN nodes have it cached" << std::endl;
     std::cout << "\nNotes:" << std::endl;
     std::cout << "  - IP ranges are auto-updated if older than 30 days" << std::endl;
-    std::cout << "  - Alive IPs cache expires after 7 days" << std::endl;
+    std::cout << "  - Each cached alive IP expires 7 days after it last answered (--ttl-hours)" << std::endl;
     std::cout << "  - --alive uses 10 threads for fast scanning" << std::endl;
     std::cout << "  - Default sampling: 100 IPs per range (--alive), 10 IPs per range (--track)" << std::endl;
     std::cout << "  - Use --force-all for complete CIDR expansion (very slow, 500k+ IPs)" << std::endl;
@@ -167,7 +436,50 @@ int Application::handleUpdateCDN() {
     }
 }
 
-int Application::handleAlive(int timeout, bool force_all, size_t num_threads) {
+int Application::handleExportAlive(const std::string& output_file) {
+    try {
+        CDNUpdater updater;
+        return updater.exportAliveIPs(output_file) ? 0 : 1;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
+
+int Application::handleMerge(const std::string& output_file, const std::vector<std::string>& inputs) {
+    try {
+        // Results files and alive lists can't be mixed
+        bool results = ResultSink::isBinaryFile(inputs[0]);
+        for (const auto& input : inputs) {
+            if (ResultSink::isBinaryFile(input) != results) {
+                std::cerr << "Error: " << input << " is not " << (results ? "a binary results file" : "an alive list")
+                          << " like " << inputs[0] << std::endl;
+                return 1;
+            }
+        }
+
+        ShardMerge::Stats stats;
+        bool merged = results ? ShardMerge::mergeResults(inputs, output_file, stats)
+                              : ShardMerge::mergeAlive(inputs, output_file, stats);
+        if (!merged) {
+            std::cerr << "Error: Failed to merge into " << output_file << std::endl;
+            return 1;
+        }
+
+        std::cout << "Merged " << stats.records << (results ? " results" : " alive IPs") << " from " << stats.files
+                  << " files into " << output_file << " (" << stats.duplicates << " duplicates dropped)" << std::endl;
+        CDNUpdater updater;
+        if (!results && output_file != updater.getAliveIPsFilePath()) {
+            std::cout << "To track with it, copy it to " << updater.getAliveIPsFilePath() << std::endl;
+        }
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
+
+int Application::handleAlive(const ScanOptions& options) {
     try {
         // Ensure IP ranges are up to date
         CDNUpdater updater;
@@ -181,8 +493,43 @@ int Application::handleAlive(int timeout, bool force_all, size_t num_threads) {
         CDNTracker tracker;
 
         // Set timeout and force_all options
-        tracker.setTimeout(timeout);
-        tracker.setForceAll(force_all);
+        long timeout_ms = options.timeout_ms > 0 ? options.timeout_ms : options.timeout * 1000L;
+        long connect_timeout_ms = options.connect_timeout_ms > 0 ? options.connect_timeout_ms : 0;
+        tracker.setTimeoutMs(connect_timeout_ms, timeout_ms);
+        tracker.setAdaptiveTimeout(options.adaptive_timeout, options.rtt_multiplier);
+        tracker.setForceAll(options.force_all);
+        tracker.setShard(options.shard_index, options.shard_count);
+        tracker.setMaxInFlight(options.max_in_flight);
+        tracker.setAdaptiveConcurrency(options.adaptive_concurrency);
+        tracker.setRetries(options.retries, options.retry_budget);
+        tracker.setConnectScan(options.connect_scan,
+                               options.connect_timeout_ms > 0 ? static_cast<int>(options.connect_timeout_ms) : 500);
+        tracker.setPinConnect(options.pin_connect);
+
+        std::unique_ptr<ResultSink> result_sink;
+        if (!openResultSink(options, result_sink)) {
+            return 1;
+        }
+        tracker.setResultSink(result_sink.get());
+
+        Dashboard dashboard;
+        if (options.tui) {
+            if (Dashboard::available()) {
+                tracker.setDashboard(&dashboard);
+            } else {
+                std::cerr << "Warning: --tui needs a terminal and a build with ncurses" << std::endl;
+            }
+        }
+
+        // Live metrics, exported until the scan is done
+        std::unique_ptr<ScanMetrics> metrics;
+        std::unique_ptr<MetricsExporter> metrics_exporter;
+        if (!options.metrics_dir.empty()) {
+            metrics.reset(new ScanMetrics());
+            metrics_exporter.reset(new MetricsExporter(*metrics, options.metrics_dir, "alive", options.metrics_interval));
+            tracker.setMetrics(metrics.get());
+            metrics_exporter->start();
+        }
 
         // Load IP ranges
         std::string ip_ranges_file = updater.getIPRangesFilePath();
@@ -192,21 +539,49 @@ int Application::handleAlive(int timeout, bool force_all, size_t num_threads) {
             return 1;
         }
 
-        // Scan for alive nodes (multi-threaded)
-        std::vector<std::string> alive_ips = tracker.scanAliveNodes(num_threads);
+        uint32_t ttl_seconds = static_cast<uint32_t>(options.ttl_hours * 3600);
+        updater.setAliveTTL(ttl_seconds);
 
-        if (alive_ips.empty()) {
+        // Refresh the cache in place, or scan for alive nodes (multi-threaded or event-driven)
+        std::vector<AliveRecord> alive_records;
+        AliveIndex alive_index;
+        if (options.refresh && updater.loadAliveIPs(alive_index)) {
+            alive_records = tracker.refreshAliveNodes(alive_index, ttl_seconds, options.dead_sample, options.num_threads);
+        } else {
+            if (options.refresh) {
+                std::cout << "No alive IPs cache to refresh, running a full scan" << std::endl;
+            }
+            // Only long scans are checkpointed unless asked for; a sampled
+            // scan keeps the default Ctrl+C behaviour
+            if (options.force_all || options.checkpoint) {
+                tracker.setCheckpoint(updater.getCheckpointFilePath(), options.checkpoint_interval, options.resume);
+            }
+            alive_records = tracker.scanAliveNodes(options.num_threads);
+        }
+        if (!closeResultSink(result_sink)) {
+            return 1;
+        }
+
+        // Partial results stay in the checkpoint until the scan is resumed
+        if (tracker.interrupted()) {
+            return 1;
+        }
+
+        if (alive_records.empty()) {
             std::cerr << "Error: No alive CDN nodes found" << std::endl;
             return 1;
         }
 
         // Save alive IPs
-        if (!updater.saveAliveIPs(alive_ips)) {
+        if (!updater.saveAliveIPs(alive_records)) {
             std::cerr << "Error: Failed to save alive IPs" << std::endl;
             return 1;
         }
 
         std::cout << "Saved alive IPs to: " << updater.getAliveIPsFilePath() << std::endl;
+        if (options.force_all || options.checkpoint) {
+            std::remove(updater.getCheckpointFilePath().c_str());
+        }
         std::cout << "\n\033[32m✓ Use --track to leverage this optimized list!\033[0m" << std::endl;
 
         return 0;
@@ -216,7 +591,7 @@ int Application::handleAlive(int timeout, bool force_all, size_t num_threads) {
     }
 }
 
-int Application::handleTrack(const std::string& identifier, const std::string& url, int timeout, bool force_all, size_t num_threads) {
+int Application::handleTrack(const std::string& identifier, const std::string& url, const ScanOptions& options) {
     try {
         Config config;
         ImageMetadata metadata;
@@ -232,6 +607,70 @@ int Application::handleTrack(const std::string& identifier, const std::string& u
         std::cout << "  Generated: " << metadata.timestamp << std::endl;
         std::cout << "  Size: " << metadata.width << "x" << metadata.height << std::endl;
 
+        // Track the image (and any extra URLs in the same pass)
+        std::vector<TrackJob> jobs{{identifier, url}};
+        for (const auto& extra_url : options.extra_urls) {
+            jobs.push_back({identifier, extra_url});
+        }
+        return runTrack(jobs, options);
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
+
+int Application::handleBatch(const std::string& job_file, const ScanOptions& options) {
+    try {
+        std::ifstream file(job_file);
+        if (!file.is_open()) {
+            std::cerr << "Error: Cannot open job file: " << job_file << std::endl;
+            return 1;
+        }
+
+        // One "<identifier> <url>" pair per line
+        Config config;
+        std::vector<TrackJob> jobs;
+        std::string line;
+        int line_number = 0;
+        while (std::getline(file, line)) {
+            line_number++;
+            line.erase(0, line.find_first_not_of(" \t\r\n"));
+            if (line.empty() || line[0] == '#') {
+                continue;
+            }
+
+            std::istringstream fields(line);
+            TrackJob job;
+            if (!(fields >> job.identifier >> job.url)) {
+                std::cerr << "Warning: " << job_file << ":" << line_number
+                          << ": expected <identifier> <url>, skipping" << std::endl;
+                continue;
+            }
+
+            ImageMetadata metadata;
+            if (!config.loadImageMetadata(job.identifier, metadata)) {
+                std::cerr << "Warning: " << job_file << ":" << line_number << ": image '" << job.identifier
+                          << "' not found in local database, skipping" << std::endl;
+                continue;
+            }
+            jobs.push_back(std::move(job));
+        }
+
+        if (jobs.empty()) {
+            std::cerr << "Error: No valid jobs in " << job_file << std::endl;
+            return 1;
+        }
+        std::cout << "Loaded " << jobs.size() << " jobs from " << job_file << std::endl;
+
+        return runTrack(jobs, options);
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
+
+int Application::runTrack(const std::vector<TrackJob>& jobs, const ScanOptions& options) {
+    try {
         // Check and update CDN IP ranges if needed
         CDNUpdater updater;
         if (updater.needsUpdate()) {
@@ -253,17 +692,57 @@ int Application::handleTrack(const std::string& identifier, const std::string& u
         CDNTracker tracker;
 
         // Set timeout and force_all options
-        tracker.setTimeout(timeout);
-        tracker.setForceAll(force_all);
+        long timeout_ms = options.timeout_ms > 0 ? options.timeout_ms : options.timeout * 1000L;
+        long connect_timeout_ms = options.connect_timeout_ms > 0 ? options.connect_timeout_ms : 0;
+        tracker.setTimeoutMs(connect_timeout_ms, timeout_ms);
+        tracker.setAdaptiveTimeout(options.adaptive_timeout, options.rtt_multiplier);
+        tracker.setForceAll(options.force_all);
+        tracker.setShard(options.shard_index, options.shard_count);
+        tracker.setMaxInFlight(options.max_in_flight);
+        tracker.setAdaptiveConcurrency(options.adaptive_concurrency);
+        tracker.setRetries(options.retries, options.retry_budget);
+        tracker.setPinConnect(options.pin_connect);
+        tracker.setPerColo(options.per_colo);
+        tracker.setShowIPTable(options.show_table);
+
+        std::unique_ptr<ResultSink> result_sink;
+        if (!openResultSink(options, result_sink)) {
+            return 1;
+        }
+        tracker.setResultSink(result_sink.get());
+
+        Dashboard dashboard;
+        if (options.tui) {
+            if (options.watch) {
+                std::cerr << "Warning: --tui is not available with --watch" << std::endl;
+            } else if (Dashboard::available()) {
+                tracker.setDashboard(&dashboard);
+            } else {
+                std::cerr << "Warning: --tui needs a terminal and a build with ncurses" << std::endl;
+            }
+        }
+
+        // Live metrics, exported until tracking is done
+        std::unique_ptr<ScanMetrics> metrics;
+        std::unique_ptr<MetricsExporter> metrics_exporter;
+        if (!options.metrics_dir.empty()) {
+            metrics.reset(new ScanMetrics());
+            metrics_exporter.reset(new MetricsExporter(*metrics, options.metrics_dir,
+                                                       options.watch ? "watch" : "track", options.metrics_interval));
+            tracker.setMetrics(metrics.get());
+            metrics_exporter->start();
+        }
 
-        // Check if we have a recent alive IPs list
+        uint32_t ttl_seconds = static_cast<uint32_t>(options.ttl_hours * 3600);
+        updater.setAliveTTL(ttl_seconds);
+
+        // Check if we have alive IPs that are still within their TTL
         if (updater.hasRecentAliveIPs()) {
-            std::vector<std::string> alive_ips;
-            if (updater.loadAliveIPs(alive_ips)) {
-                int age = updater.getAliveIPsAgeDays();
-                std::cout << "Using alive IPs cache (" << alive_ips.size()
-                          << " IPs, age: " << age << " days)" << std::endl;
-                tracker.setSpecificIPs(alive_ips);
+            AliveIndex alive_index;
+            if (updater.loadAliveIPs(alive_index)) {
+                std::cout << "Using alive IPs cache (" << alive_index.freshCount(ttl_seconds) << " of "
+                          << alive_index.size() << " IPs within TTL)" << std::endl;
+                tracker.setAliveIndex(alive_index, ttl_seconds);
             }
         } else {
             // Load all IP ranges
@@ -278,15 +757,24 @@ int Application::handleTrack(const std::string& identifier, const std::string& u
             if (alive_age < 0) {
                 std::cout << "\033[33mTip: Run 'cfpinner --alive' first to speed up tracking!\033[0m" << std::endl;
             } else {
-                std::cout << "\033[33mAlive IPs cache is " << alive_age
-                          << " days old. Run 'cfpinner --alive' to refresh.\033[0m" << std::endl;
+                std::cout << "\033[33mAll cached alive IPs are past their TTL. "
+                          << "Run 'cfpinner --alive --refresh' to refresh.\033[0m" << std::endl;
             }
         }
 
-        // Track the image
-        tracker.track(identifier, url, num_threads);
+        if (options.watch) {
+            WatchOptions watch_options;
+            watch_options.interval_s = options.watch_interval;
+            watch_options.max_interval_s = options.watch_max_interval;
+            watch_options.duration_s = options.watch_duration;
+            watch_options.log_file = options.watch_log;
+            tracker.watch(jobs, watch_options, options.num_threads);
+        } else {
+            // Every edge is visited once for all jobs
+            tracker.track(jobs, options.num_threads);
+        }
 
-        return 0;
+        return closeResultSink(result_sink) ? 0 : 1;
     } catch (const std::exception& e) {
         std::cerr << "Error: " << e.what() << std::endl;
         return 1;
@@ -1,4 +1,5 @@
 #include "cidr_utils.h"
+#include "ip_range_list.h"
 #include <sstream>
 #include <cmath>
 #include <cstdint>
@@ -64,61 +65,17 @@ bool CIDRUtils::parseCIDR(const std::string& cidr, uint32_t& base_ip, int& prefi
 }
 
 std::vector<std::string> CIDRUtils::expandCIDR(const std::string& cidr, size_t max_ips) {
-    std::vector<std::string> ips;
-
-    uint32_t base_ip;
-    int prefix_len;
-
-    if (!parseCIDR(cidr, base_ip, prefix_len)) {
-        return ips;
-    }
-
-    uint32_t total_hosts = getHostCount(prefix_len);
-
-    // Check if force-all mode (max_ips == SIZE_MAX means no limit)
-    bool force_all = (max_ips == SIZE_MAX);
+    // Sampling and network/broadcast skipping live in IPRangeList
+    IPRangeList range;
+    range.addRange(cidr, max_ips);
 
-    // For very large ranges, sample strategically (unless force-all is enabled)
-    if (total_hosts > max_ips && !force_all) {
-        // Use strategic sampling to get good coverage across the range
-        // Distribute samples evenly across the entire IP space
-        uint32_t step = total_hosts / max_ips;
-
-        for (size_t i = 0; i < max_ips; i++) {
-            uint32_t offset = i * step;
-
-            // Add some variation within each segment to avoid only checking
-            // the first IP of each subnet
-            if (i > 0 && step > 4) {
-                // Add offset of 1-3 to check different IPs in subnet
-                offset += (i % 4);
-            }
-
-            // Skip network address (first) and broadcast address (last)
-            if (offset == 0 && total_hosts > 2) {
-                offset = 1;
-            }
-            if (offset >= total_hosts - 1 && total_hosts > 2) {
-                offset = total_hosts - 2;
-            }
-
-            uint32_t ip = base_ip + offset;
-            ips.push_back(uint32ToIp(ip));
-        }
-    } else {
-        // Small range, include all IPs
-        for (uint32_t i = 0; i < total_hosts; i++) {
-            // Skip network address and broadcast address for ranges > /31
-            if (prefix_len < 31) {
-                if (i == 0 || i == total_hosts - 1) {
-                    continue;
-                }
-            }
-            uint32_t ip = base_ip + i;
-            ips.push_back(uint32ToIp(ip));
-        }
+    std::vector<std::string> ips;
+    ips.reserve(range.size());
+    IPRangeList::Cursor cursor(range);
+    uint32_t ip;
+    while (cursor.next(ip)) {
+        ips.push_back(uint32ToIp(ip));
     }
-
     return ips;
 }
 
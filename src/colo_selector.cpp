@@ -0,0 +1,68 @@
+#include "colo_selector.h"
+#include "result_store.h"
+#include <algorithm>
+#include <unordered_set>
+
+namespace cfpinner {
+
+ColoSelector::ColoSelector(const std::vector<AliveRecord>& records, size_t per_colo)
+    : per_colo_(std::max<size_t>(per_colo, 1)), standbys_(0) {
+    std::unordered_map<uint16_t, size_t> index_of;
+    for (const auto& record : records) {
+        if (record.iata == 0) {
+            unknown_.push_back(record.ip);
+            continue;
+        }
+
+        auto it = index_of.find(record.iata);
+        if (it == index_of.end()) {
+            it = index_of.emplace(record.iata, colos_.size()).first;
+            colos_.emplace_back();
+        }
+        colos_[it->second].ips.push_back(record.ip);
+        colo_of_[record.ip] = it->second;
+    }
+}
+
+IPRangeList ColoSelector::representatives() {
+    IPRangeList ips;
+    standbys_ = 0;
+    for (auto& colo : colos_) {
+        colo.next = std::min(per_colo_, colo.ips.size());
+        for (size_t i = 0; i < colo.next; i++) {
+            ips.addAddress(colo.ips[i]);
+        }
+        standbys_ += colo.ips.size() - colo.next;
+    }
+    for (uint32_t ip : unknown_) {
+        ips.addAddress(ip);
+    }
+    return ips;
+}
+
+IPRangeList ColoSelector::failover(const ResultStore& results, size_t first) {
+    // An IP counts as failed if any of its probes (one per URL) errored
+    std::vector<uint32_t> failed;
+    std::unordered_set<uint32_t> seen;
+    for (size_t i = first; i < results.size(); i++) {
+        if (results.isError(i) && seen.insert(results.ip(i)).second) {
+            failed.push_back(results.ip(i));
+        }
+    }
+
+    IPRangeList replacements;
+    for (uint32_t ip : failed) {
+        auto it = colo_of_.find(ip);
+        if (it == colo_of_.end()) {
+            continue;
+        }
+        Colo& colo = colos_[it->second];
+        if (colo.next < colo.ips.size()) {
+            replacements.addAddress(colo.ips[colo.next++]);
+            standbys_--;
+        }
+    }
+    return replacements;
+}
+
+} // namespace cfpinner
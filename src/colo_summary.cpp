@@ -0,0 +1,69 @@
+#include "colo_summary.h"
+#include <algorithm>
+
+namespace cfpinner {
+
+// encodeIATA yields 1..26^3, with 0 for no colo
+static const size_t IATA_SLOTS = 26 * 26 * 26 + 1;
+
+ColoSummary::ColoSummary() : slots_(IATA_SLOTS, 0) {
+}
+
+void ColoSummary::add(const ResultStore& results, size_t index, uint16_t fallback_iata) {
+    uint16_t iata = results.iata(index);
+    if (iata == 0 || iata >= IATA_SLOTS) {
+        iata = fallback_iata < IATA_SLOTS ? fallback_iata : 0;
+    }
+
+    uint16_t& slot = slots_[iata];
+    if (slot == 0) {
+        colos_.emplace_back();
+        colos_.back().iata = iata;
+        slot = static_cast<uint16_t>(colos_.size());
+    }
+    Colo& colo = colos_[slot - 1];
+
+    if (results.isError(index)) {
+        colo.errors++;
+        return;
+    }
+    if (results.isHit(index)) {
+        colo.hits++;
+    } else {
+        colo.misses++;
+    }
+
+    if (colo.country == 0) {
+        colo.country = results.country(index);
+    }
+
+    // Reused connections report no connect time
+    uint32_t connect_us = results.connectTimeUs(index);
+    if (connect_us > 0) {
+        colo.connect_us_sum += connect_us;
+        colo.connect_samples++;
+        if (colo.min_connect_us == 0 || connect_us < colo.min_connect_us) {
+            colo.min_connect_us = connect_us;
+        }
+    }
+}
+
+std::vector<ColoSummary::Colo> ColoSummary::sorted() const {
+    std::vector<Colo> colos = colos_;
+    std::sort(colos.begin(), colos.end(), [](const Colo& a, const Colo& b) {
+        // Results without a colo go last
+        if ((a.iata == 0) != (b.iata == 0)) {
+            return b.iata == 0;
+        }
+        if (a.hits != b.hits) {
+            return a.hits > b.hits;
+        }
+        if (a.total() != b.total()) {
+            return a.total() > b.total();
+        }
+        return a.iata < b.iata;
+    });
+    return colos;
+}
+
+} // namespace cfpinner
@@ -0,0 +1,142 @@
+#include "concurrency_controller.h"
+#include <algorithm>
+
+namespace cfpinner {
+
+// Probes per decision window, at least (limit is used above this)
+static const size_t kMinWindow = 32;
+
+// A window is degraded when the congestion error rate rises this much above
+// the baseline (absolute and relative), or the median latency doubles
+static const double kErrorRateSlack = 0.05;
+static const double kErrorRateFactor = 1.5;
+static const double kLatencyFactor = 2.0;
+
+// Multiplicative decrease, and how many times in a row it is tried before
+// a degradation is blamed on the targets instead
+static const double kBackoffFactor = 0.7;
+static const size_t kMaxBackoffStreak = 3;
+
+ConcurrencyController::ConcurrencyController(size_t min_limit, size_t max_limit, size_t initial_limit)
+    : min_limit_(std::max<size_t>(min_limit, 1)),
+      max_limit_(std::max(max_limit, std::max<size_t>(min_limit, 1))),
+      limit_(0),
+      peak_limit_(0),
+      backoffs_(0),
+      phase_(SLOW_START),
+      last_action_("start"),
+      window_count_(0),
+      window_congested_(0),
+      baseline_error_rate_(-1.0),
+      baseline_latency_us_(-1),
+      backoff_error_rate_(0.0),
+      backoff_latency_us_(0),
+      limit_before_backoff_(0),
+      backoff_streak_(0) {
+    setLimit(initial_limit);
+}
+
+void ConcurrencyController::setLimit(size_t limit) {
+    size_t clamped = std::min(std::max(limit, min_limit_), max_limit_);
+    limit_.store(clamped, std::memory_order_relaxed);
+    peak_limit_ = std::max(peak_limit_, clamped);
+}
+
+void ConcurrencyController::record(bool success, bool congested, long latency_us) {
+    window_count_++;
+    if (congested) {
+        window_congested_++;
+    }
+    if (success && latency_us > 0) {
+        window_latency_us_.push_back(latency_us);
+    }
+
+    if (window_count_ >= std::max(kMinWindow, limit_.load(std::memory_order_relaxed))) {
+        closeWindow();
+    }
+}
+
+void ConcurrencyController::closeWindow() {
+    double error_rate = static_cast<double>(window_congested_) / window_count_;
+    long latency_us = -1;
+    if (!window_latency_us_.empty()) {
+        auto middle = window_latency_us_.begin() + window_latency_us_.size() / 2;
+        std::nth_element(window_latency_us_.begin(), middle, window_latency_us_.end());
+        latency_us = *middle;
+    }
+
+    window_count_ = 0;
+    window_congested_ = 0;
+    window_latency_us_.clear();
+
+    if (baseline_error_rate_ < 0) {
+        // First window: whatever we see at the initial limit is normal
+        baseline_error_rate_ = error_rate;
+        baseline_latency_us_ = latency_us;
+    }
+
+    bool errors_up = error_rate > baseline_error_rate_ + kErrorRateSlack &&
+                     error_rate > baseline_error_rate_ * kErrorRateFactor;
+    bool latency_up = latency_us > 0 && baseline_latency_us_ > 0 &&
+                      latency_us > baseline_latency_us_ * kLatencyFactor;
+
+    if (phase_ == PROBING_BACKOFF) {
+        // Did the backoffs help? If the signal barely moved after several, the
+        // errors or the latency belong to the targets being scanned, not to our load
+        bool errors_stuck = errors_up && error_rate >= backoff_error_rate_ * 0.8;
+        bool latency_stuck = latency_up && latency_us >= backoff_latency_us_ * 0.8;
+        if ((errors_stuck || latency_stuck) && backoff_streak_ < kMaxBackoffStreak) {
+            setLimit(static_cast<size_t>(limit_ * kBackoffFactor));
+            backoff_streak_++;
+            backoffs_++;
+            last_action_ = errors_up ? "backoff:errors" : "backoff:latency";
+            return;
+        }
+        if (errors_stuck || latency_stuck) {
+            baseline_error_rate_ = error_rate;
+            if (latency_us > 0) {
+                baseline_latency_us_ = latency_us;
+            }
+            setLimit(limit_before_backoff_);
+            phase_ = STEADY;
+            last_action_ = "rebase";
+            return;
+        }
+    }
+
+    if (errors_up || latency_up) {
+        limit_before_backoff_ = limit_;
+        backoff_error_rate_ = error_rate;
+        backoff_latency_us_ = latency_us;
+        backoff_streak_ = 1;
+        setLimit(static_cast<size_t>(limit_ * kBackoffFactor));
+        phase_ = PROBING_BACKOFF;
+        backoffs_++;
+        last_action_ = errors_up ? "backoff:errors" : "backoff:latency";
+        return;
+    }
+
+    // Healthy window: track the baselines and grow
+    baseline_error_rate_ = baseline_error_rate_ * 0.8 + error_rate * 0.2;
+    if (latency_us > 0 && (baseline_latency_us_ < 0 || latency_us < baseline_latency_us_)) {
+        baseline_latency_us_ = latency_us;
+    }
+
+    if (limit_ >= max_limit_) {
+        phase_ = phase_ == SLOW_START ? SLOW_START : STEADY;
+        last_action_ = "max";
+    } else if (phase_ == SLOW_START) {
+        setLimit(limit_ * 2);
+        last_action_ = "ramp";
+    } else {
+        setLimit(limit_ + std::max<size_t>(min_limit_, 8));
+        phase_ = STEADY;
+        last_action_ = "grow";
+    }
+}
+
+std::string ConcurrencyController::describe() const {
+    return std::to_string(limit_.load(std::memory_order_relaxed)) + " " + last_action_.load(std::memory_order_relaxed);
+}
+
+} // namespace cfpinner
@@ -0,0 +1,192 @@
+#include "connect_scanner.h"
+#include "probe_engine.h"
+#include <iostream>
+#include <stdexcept>
+#include <chrono>
+#include <deque>
+#include <cerrno>
+#include <cstring>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+
+namespace cfpinner {
+
+static long long nowMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Close without lingering in TIME_WAIT; the peer gets a RST
+static void closeAbortive(int fd) {
+    struct linger lg;
+    lg.l_onoff = 1;
+    lg.l_linger = 0;
+    setsockopt(fd, SOL_SOCKET, SO_LINGER, &lg, sizeof(lg));
+    close(fd);
+}
+
+ConnectScanner::ConnectScanner(size_t max_in_flight)
+    : epoll_fd_(-1),
+      timeout_ms_(500),
+      port_(443),
+      max_in_flight_(1),
+      stop_(nullptr) {
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd_ < 0) {
+        throw std::runtime_error("Failed to create epoll instance");
+    }
+    setMaxInFlight(max_in_flight);
+}
+
+ConnectScanner::~ConnectScanner() {
+    close(epoll_fd_);
+}
+
+void ConnectScanner::setTimeoutMs(int timeout_ms) {
+    timeout_ms_ = timeout_ms > 0 ? timeout_ms : 1;
+}
+
+void ConnectScanner::setPort(uint16_t port) {
+    port_ = port;
+}
+
+void ConnectScanner::setMaxInFlight(size_t max_in_flight) {
+    // Every half-open connect holds a descriptor
+    size_t fd_limit = ProbeEngine::raiseFileLimit();
+    size_t usable = fd_limit > 64 ? fd_limit - 64 : 1;
+
+    if (max_in_flight > usable) {
+        std::cerr << "Warning: limiting in-flight connects to " << usable
+                  << " (open file limit is " << fd_limit << ")" << std::endl;
+        max_in_flight = usable;
+    }
+    max_in_flight_ = max_in_flight > 0 ? max_in_flight : 1;
+}
+
+void ConnectScanner::setStopFlag(const std::atomic<bool>* stop) {
+    stop_ = stop;
+}
+
+void ConnectScanner::scan(const IPRangeList& ips, const ConnectCallback& on_result) {
+    std::vector<Slot> slots(max_in_flight_);
+    std::vector<size_t> free_slots;
+    free_slots.reserve(max_in_flight_);
+    for (size_t i = max_in_flight_; i > 0; i--) {
+        slots[i - 1].fd = -1;
+        slots[i - 1].generation = 0;
+        free_slots.push_back(i - 1);
+    }
+
+    // All connects share one timeout, so deadlines expire in start order
+    struct Deadline {
+        long long at_ms;
+        size_t slot;
+        uint32_t generation;
+    };
+    std::deque<Deadline> deadlines;
+
+    const int max_events = 1024;
+    struct epoll_event events[max_events];
+    IPRangeList::Cursor cursor(ips);
+    uint32_t next_ip = 0;
+    bool have_next = cursor.next(next_ip);
+    size_t in_flight = 0;
+
+    auto release = [&](size_t slot_index, bool is_open) {
+        Slot& slot = slots[slot_index];
+        epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, slot.fd, nullptr);
+        closeAbortive(slot.fd);
+        slot.fd = -1;
+        slot.generation++;
+        free_slots.push_back(slot_index);
+        in_flight--;
+        on_result(slot.ip, is_open);
+    };
+
+    while (have_next || in_flight > 0) {
+        if (have_next && stop_ && stop_->load()) {
+            have_next = false;
+        }
+
+        // Start new connects while there are free slots
+        while (have_next && !free_slots.empty()) {
+            uint32_t target = next_ip;
+
+            struct sockaddr_in addr;
+            std::memset(&addr, 0, sizeof(addr));
+            addr.sin_family = AF_INET;
+            addr.sin_port = htons(port_);
+            addr.sin_addr.s_addr = htonl(target);
+
+            int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+            if (fd < 0) {
+                if (in_flight == 0) {
+                    on_result(target, false);
+                    have_next = cursor.next(next_ip);
+                    continue;
+                }
+                // Out of descriptors; retry once in-flight connects drain
+                break;
+            }
+            have_next = cursor.next(next_ip);
+
+            int rc = connect(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr));
+            if (rc == 0 || errno != EINPROGRESS) {
+                // Loopback can connect immediately; anything else is a hard failure
+                bool is_open = (rc == 0);
+                closeAbortive(fd);
+                on_result(target, is_open);
+                continue;
+            }
+
+            size_t slot_index = free_slots.back();
+            free_slots.pop_back();
+            Slot& slot = slots[slot_index];
+            slot.fd = fd;
+            slot.ip = target;
+
+            struct epoll_event ev = {};
+            ev.events = EPOLLOUT;
+            ev.data.u64 = slot_index;
+            epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev);
+
+            deadlines.push_back({nowMs() + timeout_ms_, slot_index, slot.generation});
+            in_flight++;
+        }
+
+        if (in_flight == 0) {
+            continue;
+        }
+
+        int wait_ms = 0;
+        if (!deadlines.empty()) {
+            long long remaining = deadlines.front().at_ms - nowMs();
+            wait_ms = remaining > 0 ? static_cast<int>(remaining) : 0;
+        }
+
+        int n = epoll_wait(epoll_fd_, events, max_events, wait_ms);
+        for (int i = 0; i < n; i++) {
+            size_t slot_index = static_cast<size_t>(events[i].data.u64);
+            int so_error = 0;
+            socklen_t len = sizeof(so_error);
+            getsockopt(slots[slot_index].fd, SOL_SOCKET, SO_ERROR, &so_error, &len);
+            release(slot_index, so_error == 0);
+        }
+
+        // Expire connects that have not completed in time
+        long long now = nowMs();
+        while (!deadlines.empty() && deadlines.front().at_ms <= now) {
+            Deadline deadline = deadlines.front();
+            deadlines.pop_front();
+            Slot& slot = slots[deadline.slot];
+            if (slot.fd >= 0 && slot.generation == deadline.generation) {
+                release(deadline.slot, false);
+            }
+        }
+    }
+}
+
+} // namespace cfpinner
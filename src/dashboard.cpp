@@ -0,0 +1,389 @@
+#include "dashboard.h"
+#include "result_pipeline.h"
+#include "result_store.h"
+#include "cdn_tracker.h"
+#include "cidr_utils.h"
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <unistd.h>
+
+#ifdef CFPINNER_HAVE_CURSES
+#define NCURSES_NOMACROS
+#include <curses.h>
+#endif
+
+namespace cfpinner {
+
+// encodeIATA yields 1..26^3, with 0 for no colo
+static const size_t IATA_SLOTS = 26 * 26 * 26 + 1;
+
+std::string Dashboard::CaptureBuffer::text() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return text_;
+}
+
+std::string Dashboard::CaptureBuffer::lastLine() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // Last non-blank segment; \r progress redraws count as line breaks
+    size_t end = text_.size();
+    while (end > 0) {
+        size_t start = text_.find_last_of("\r\n", end - 1);
+        start = start == std::string::npos ? 0 : start + 1;
+        if (text_.find_first_not_of(" \t", start) < end) {
+            return text_.substr(start, end - start);
+        }
+        end = start > 0 ? start - 1 : 0;
+    }
+    return "";
+}
+
+int Dashboard::CaptureBuffer::overflow(int c) {
+    if (c != traits_type::eof()) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        text_ += static_cast<char>(c);
+    }
+    return c;
+}
+
+std::streamsize Dashboard::CaptureBuffer::xsputn(const char* data, std::streamsize count) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    text_.append(data, static_cast<size_t>(count));
+    return count;
+}
+
+Dashboard::Dashboard(unsigned frames_per_second)
+    : frame_ms_(1000 / std::max(1u, std::min(frames_per_second, 60u))),
+      active_(false),
+      chunks_(new std::atomic<Row*>[MAX_CHUNKS]),
+      row_count_(0), result_count_(0), expected_(0), hits_(0), misses_(0), errors_(0),
+      colos_(new ColoCounters[IATA_SLOTS]),
+      seen_colos_(new uint16_t[IATA_SLOTS]),
+      seen_colo_count_(0),
+      scan_done_(false), quit_(false),
+      saved_cout_(nullptr) {
+    for (size_t i = 0; i < MAX_CHUNKS; i++) {
+        chunks_[i].store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+Dashboard::~Dashboard() {
+    if (active_) {
+        quit_ = true;
+        end();
+    }
+    for (size_t i = 0; i < MAX_CHUNKS; i++) {
+        delete[] chunks_[i].load(std::memory_order_relaxed);
+    }
+}
+
+bool Dashboard::available() {
+#ifdef CFPINNER_HAVE_CURSES
+    return isatty(STDIN_FILENO) && isatty(STDOUT_FILENO);
+#else
+    return false;
+#endif
+}
+
+void Dashboard::begin(const std::vector<TrackJob>& jobs, size_t expected_results, const std::string& title) {
+    if (active_ || !available()) {
+        return;
+    }
+
+    title_ = title;
+    labels_.clear();
+    for (const auto& job : jobs) {
+        labels_.push_back(jobs.size() > 1 ? job.identifier + " " + job.url : job.url);
+    }
+    expected_ = expected_results;
+    scan_done_ = false;
+
+    std::cout.flush();
+    saved_cout_ = std::cout.rdbuf(&capture_);
+    active_ = true;
+    render_thread_ = std::thread(&Dashboard::renderLoop, this);
+}
+
+void Dashboard::addExpected(size_t count) {
+    expected_.fetch_add(count, std::memory_order_relaxed);
+}
+
+void Dashboard::add(const ResultEvent& event) {
+    size_t index = result_count_.load(std::memory_order_relaxed);
+    result_count_.store(index + 1, std::memory_order_relaxed);
+
+    Row entry;
+    entry.ip = event.ip;
+    entry.connect_time_us = event.connect_time_us;
+    entry.url_index = event.url_index;
+    entry.iata = event.success ? ResultStore::encodeIATA(event.headers.iata_code) : 0;
+    entry.country = event.success ? ResultStore::encodeCountry(event.headers.ip_country) : 0;
+    entry.status_code = event.status_code;
+    entry.cache_status = static_cast<uint8_t>(event.success ? ResultStore::parseCacheStatus(event.headers.cache_status)
+                                                            : CacheStatus::NONE);
+    entry.error = static_cast<uint8_t>(event.success ? ErrorClass::NONE : ResultStore::classifyError(event.curl_code));
+
+    // Rows are published by the release store of row_count_
+    if (index < CHUNK_ROWS * MAX_CHUNKS) {
+        std::atomic<Row*>& chunk = chunks_[index / CHUNK_ROWS];
+        Row* rows = chunk.load(std::memory_order_relaxed);
+        if (!rows) {
+            rows = new Row[CHUNK_ROWS];
+            chunk.store(rows, std::memory_order_relaxed);
+        }
+        rows[index % CHUNK_ROWS] = entry;
+        row_count_.store(index + 1, std::memory_order_release);
+    }
+
+    ColoCounters& colo = colos_[entry.iata < IATA_SLOTS ? entry.iata : 0];
+    if (colo.hits.load(std::memory_order_relaxed) + colo.misses.load(std::memory_order_relaxed) +
+        colo.errors.load(std::memory_order_relaxed) == 0) {
+        size_t seen = seen_colo_count_.load(std::memory_order_relaxed);
+        seen_colos_[seen] = entry.iata;
+        seen_colo_count_.store(seen + 1, std::memory_order_release);
+    }
+    if (entry.error != static_cast<uint8_t>(ErrorClass::NONE)) {
+        colo.errors.fetch_add(1, std::memory_order_relaxed);
+        errors_.fetch_add(1, std::memory_order_relaxed);
+    } else if (entry.cache_status == static_cast<uint8_t>(CacheStatus::HIT)) {
+        colo.hits.fetch_add(1, std::memory_order_relaxed);
+        hits_.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        colo.misses.fetch_add(1, std::memory_order_relaxed);
+        misses_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void Dashboard::end() {
+    if (!active_) {
+        return;
+    }
+    scan_done_ = true;
+    render_thread_.join();
+    active_ = false;
+
+    std::cout.rdbuf(saved_cout_);
+    std::cout << capture_.text() << std::flush;
+}
+
+const Dashboard::Row& Dashboard::row(size_t index) const {
+    return chunks_[index / CHUNK_ROWS].load(std::memory_order_relaxed)[index % CHUNK_ROWS];
+}
+
+#ifdef CFPINNER_HAVE_CURSES
+
+enum ColorPair : short {
+    PAIR_HIT = 1,
+    PAIR_MISS,
+    PAIR_ERROR,
+    PAIR_BAR
+};
+
+void Dashboard::renderLoop() {
+    initscr();
+    cbreak();
+    noecho();
+    keypad(stdscr, TRUE);
+    curs_set(0);
+    wtimeout(stdscr, static_cast<int>(frame_ms_));
+    if (has_colors()) {
+        start_color();
+        use_default_colors();
+        init_pair(PAIR_HIT, COLOR_GREEN, -1);
+        init_pair(PAIR_MISS, COLOR_YELLOW, -1);
+        init_pair(PAIR_ERROR, COLOR_RED, -1);
+        init_pair(PAIR_BAR, COLOR_BLACK, COLOR_CYAN);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    auto rate_time = start;
+    size_t rate_count = 0;
+    double rate = 0;
+
+    size_t top = 0;        // First row on screen
+    bool follow = true;    // Keep the newest rows in view
+    const int colo_width = 30;
+
+    while (!quit_) {
+        int rows_on_screen = std::max(LINES - 5, 1);
+        int list_width = std::max(COLS - colo_width - 1, 20);
+
+        size_t count = row_count_.load(std::memory_order_acquire);
+        size_t results = result_count_.load(std::memory_order_relaxed);
+        size_t expected = std::max(expected_.load(std::memory_order_relaxed), results);
+
+        // Throughput over roughly the last second
+        auto now = std::chrono::steady_clock::now();
+        double since_rate = std::chrono::duration<double>(now - rate_time).count();
+        if (since_rate >= 1.0) {
+            rate = (results - rate_count) / since_rate;
+            rate_count = results;
+            rate_time = now;
+        }
+        long elapsed = static_cast<long>(std::chrono::duration<double>(now - start).count());
+
+        size_t max_top = count > static_cast<size_t>(rows_on_screen) ? count - rows_on_screen : 0;
+        if (follow || top > max_top) {
+            top = max_top;
+        }
+
+        werase(stdscr);
+
+        // Title bar
+        char line[512];
+        snprintf(line, sizeof(line), " cfpinner | %s | %02ld:%02ld:%02ld | %zu/%zu (%.1f%%) | %.0f probes/s",
+                 title_.c_str(), elapsed / 3600, elapsed / 60 % 60, elapsed % 60, results, expected,
+                 expected ? results * 100.0 / expected : 0.0, rate);
+        attron(COLOR_PAIR(PAIR_BAR));
+        mvhline(0, 0, ' ', COLS);
+        mvaddnstr(0, 0, line, COLS);
+        attroff(COLOR_PAIR(PAIR_BAR));
+
+        // Totals
+        size_t seen_colos = seen_colo_count_.load(std::memory_order_acquire);
+        move(1, 1);
+        attron(COLOR_PAIR(PAIR_HIT));
+        printw("HIT %zu", hits_.load(std::memory_order_relaxed));
+        attroff(COLOR_PAIR(PAIR_HIT));
+        addstr("   ");
+        attron(COLOR_PAIR(PAIR_MISS));
+        printw("MISS %zu", misses_.load(std::memory_order_relaxed));
+        attroff(COLOR_PAIR(PAIR_MISS));
+        addstr("   ");
+        attron(COLOR_PAIR(PAIR_ERROR));
+        printw("ERROR %zu", errors_.load(std::memory_order_relaxed));
+        attroff(COLOR_PAIR(PAIR_ERROR));
+        printw("   colos %zu", seen_colos);
+        if (results > count) {
+            printw("   (list holds the first %zu results)", count);
+        }
+
+        // Result list: only the visible window is decoded
+        attron(A_BOLD);
+        snprintf(line, sizeof(line), "%9s  %-15s  %-6s  %-11s  %-4s  %-3s  %8s  %s",
+                 "#", "IP", "Status", "Cache", "Colo", "CC", "Connect", "URL");
+        mvaddnstr(2, 0, line, list_width);
+        mvaddnstr(2, list_width + 1, "Colo     HIT    MISS     ERR", colo_width);
+        attroff(A_BOLD);
+
+        for (int y = 0; y < rows_on_screen && top + y < count; y++) {
+            const Row& entry = row(top + y);
+            short pair = PAIR_MISS;
+            const char* status = "MISS";
+            if (entry.error != static_cast<uint8_t>(ErrorClass::NONE)) {
+                pair = PAIR_ERROR;
+                status = "ERROR";
+            } else if (entry.cache_status == static_cast<uint8_t>(CacheStatus::HIT)) {
+                pair = PAIR_HIT;
+                status = "HIT";
+            }
+
+            std::string cache = entry.error != static_cast<uint8_t>(ErrorClass::NONE)
+                                    ? ResultStore::errorClassName(static_cast<ErrorClass>(entry.error))
+                                    : ResultStore::cacheStatusName(static_cast<CacheStatus>(entry.cache_status));
+            std::string iata = ResultStore::decodeIATA(entry.iata);
+            std::string country = ResultStore::decodeCountry(entry.country);
+            char connect[16] = "-";
+            if (entry.connect_time_us > 0) {
+                snprintf(connect, sizeof(connect), "%.1fms", entry.connect_time_us / 1000.0);
+            }
+            const std::string& label = entry.url_index < labels_.size() ? labels_[entry.url_index] : "";
+
+            snprintf(line, sizeof(line), "%9zu  %-15s  ", top + y + 1, CIDRUtils::uint32ToIp(entry.ip).c_str());
+            mvaddnstr(3 + y, 0, line, list_width);
+            attron(COLOR_PAIR(pair));
+            printw("%-6s", status);
+            attroff(COLOR_PAIR(pair));
+            snprintf(line, sizeof(line), "  %-11.11s  %-4s  %-3s  %8s  %s",
+                     cache.empty() ? "-" : cache.c_str(), iata.empty() ? "-" : iata.c_str(),
+                     country.empty() ? "-" : country.c_str(), connect, label.c_str());
+            int x = getcurx(stdscr);
+            if (x < list_width) {
+                addnstr(line, list_width - x);
+            }
+        }
+
+        // Per-colo counters, most hits first
+        std::vector<uint16_t> colos(seen_colos_.get(), seen_colos_.get() + seen_colos);
+        std::sort(colos.begin(), colos.end(), [&](uint16_t a, uint16_t b) {
+            uint32_t hits_a = colos_[a].hits.load(std::memory_order_relaxed);
+            uint32_t hits_b = colos_[b].hits.load(std::memory_order_relaxed);
+            return hits_a != hits_b ? hits_a > hits_b : a < b;
+        });
+        for (int y = 0; y < rows_on_screen && y < static_cast<int>(colos.size()); y++) {
+            const ColoCounters& counters = colos_[colos[y]];
+            std::string iata = ResultStore::decodeIATA(colos[y]);
+            snprintf(line, sizeof(line), "%-4s %7u %7u %7u", iata.empty() ? "-" : iata.c_str(),
+                     counters.hits.load(std::memory_order_relaxed), counters.misses.load(std::memory_order_relaxed),
+                     counters.errors.load(std::memory_order_relaxed));
+            mvaddnstr(3 + y, list_width + 1, line, colo_width);
+        }
+        mvvline(2, list_width, ACS_VLINE, rows_on_screen + 1);
+
+        // Status bar: latest console message and keys
+        std::string status = scan_done_ ? "Scan complete. Press q to close the dashboard." : capture_.lastLine();
+        snprintf(line, sizeof(line), " %s", status.c_str());
+        attron(COLOR_PAIR(PAIR_BAR));
+        mvhline(LINES - 2, 0, ' ', COLS);
+        mvaddnstr(LINES - 2, 0, line, COLS);
+        attroff(COLOR_PAIR(PAIR_BAR));
+        snprintf(line, sizeof(line), " Up/Down PgUp/PgDn Home/End scroll   f %s   q quit%s",
+                 follow ? "stop following" : "follow new results", scan_done_ ? "" : " (after the scan)");
+        mvaddnstr(LINES - 1, 0, line, COLS);
+
+        wrefresh(stdscr);
+
+        // Waits up to one frame for a key, which caps the frame rate
+        int key = wgetch(stdscr);
+        switch (key) {
+            case KEY_UP:
+                follow = false;
+                top = top > 0 ? top - 1 : 0;
+                break;
+            case KEY_DOWN:
+                top = std::min(top + 1, max_top);
+                follow = top == max_top;
+                break;
+            case KEY_PPAGE:
+                follow = false;
+                top = top > static_cast<size_t>(rows_on_screen) ? top - rows_on_screen : 0;
+                break;
+            case KEY_NPAGE:
+                top = std::min(top + rows_on_screen, max_top);
+                follow = top == max_top;
+                break;
+            case KEY_HOME:
+                follow = false;
+                top = 0;
+                break;
+            case KEY_END:
+                follow = true;
+                break;
+            case 'f':
+            case 'F':
+                follow = !follow;
+                break;
+            case 'q':
+            case 'Q':
+                if (scan_done_) {
+                    quit_ = true;
+                }
+                break;
+            default:
+                break;
+        }
+    }
+
+    endwin();
+}
+
+#else
+
+void Dashboard::renderLoop() {
+}
+
+#endif
+
+} // namespace cfpinner
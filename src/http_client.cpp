@@ -2,70 +2,187 @@
 #include <curl/curl.h>
 #include <iostream>
 #include <cstring>
+#include <stdexcept>
 
 namespace cfpinner {
 
-// Callback for CURL to write headers
-static size_t header_callback(char* buffer, size_t size, size_t nitems, void* userdata) {
-    size_t total_size = size * nitems;
-    std::string* headers = static_cast<std::string*>(userdata);
-    headers->append(buffer, total_size);
-    return total_size;
+// Process-wide libcurl initialization, cleaned up at exit
+struct CurlGlobal {
+    CurlGlobal() { curl_global_init(CURL_GLOBAL_DEFAULT); }
+    ~CurlGlobal() { curl_global_cleanup(); }
+};
+
+void HTTPClient::globalInit() {
+    static CurlGlobal global;
+    (void)global;
+}
+
+bool HTTPClient::isTransientError(int curl_code) {
+    switch (curl_code) {
+        case CURLE_OPERATION_TIMEDOUT:
+        case CURLE_SEND_ERROR:
+        case CURLE_RECV_ERROR:
+        case CURLE_SSL_CONNECT_ERROR:
+        case CURLE_GOT_NOTHING:
+        case CURLE_PARTIAL_FILE:
+            return true;
+        default:
+            return false;
+    }
+}
+
+CurlShare::CurlShare() {
+    HTTPClient::globalInit();
+
+    share_ = curl_share_init();
+    if (!share_) {
+        throw std::runtime_error("Failed to initialize CURL share handle");
+    }
+
+    curl_share_setopt(share_, CURLSHOPT_LOCKFUNC, lockCallback);
+    curl_share_setopt(share_, CURLSHOPT_UNLOCKFUNC, unlockCallback);
+    curl_share_setopt(share_, CURLSHOPT_USERDATA, this);
+    curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+
+    // Not CURL_LOCK_DATA_CONNECT: a connection cache must not be used by
+    // handles running on several threads at once; connections stay with
+    // each worker's handle or the engine's multi handle
+}
+
+CurlShare::~CurlShare() {
+    curl_share_cleanup(share_);
+}
+
+CURLSH* CurlShare::handle() const {
+    return share_;
+}
+
+void CurlShare::lockCallback(CURL* /*handle*/, curl_lock_data data, curl_lock_access /*access*/, void* userptr) {
+    static_cast<CurlShare*>(userptr)->locks_[data].lock();
+}
+
+void CurlShare::unlockCallback(CURL* /*handle*/, curl_lock_data data, void* userptr) {
+    static_cast<CurlShare*>(userptr)->locks_[data].unlock();
 }
 
 HTTPClient::HTTPClient()
-    : timeout_seconds_(5),
-      user_agent_("CFPinner/1.0") {
-    curl_global_init(CURL_GLOBAL_DEFAULT);
+    : connect_timeout_ms_(0),
+      timeout_ms_(5000),
+      user_agent_("CFPinner/1.0"),
+      curl_(nullptr),
+      host_list_(nullptr),
+      connect_to_set_(false) {
+    globalInit();
 }
 
 HTTPClient::~HTTPClient() {
-    curl_global_cleanup();
+    if (host_list_) {
+        curl_slist_free_all(host_list_);
+    }
+    if (curl_) {
+        curl_easy_cleanup(curl_);
+    }
 }
 
 void HTTPClient::setTimeout(int timeout_seconds) {
-    timeout_seconds_ = timeout_seconds;
+    setTimeoutMs(0, timeout_seconds * 1000L);
+}
+
+void HTTPClient::setTimeoutMs(long connect_timeout_ms, long timeout_ms) {
+    connect_timeout_ms_ = connect_timeout_ms;
+    timeout_ms_ = timeout_ms;
 }
 
 void HTTPClient::setUserAgent(const std::string& user_agent) {
     user_agent_ = user_agent;
+    if (curl_) {
+        curl_easy_setopt(curl_, CURLOPT_USERAGENT, user_agent_.c_str());
+    }
 }
 
-HTTPResponse HTTPClient::head(const std::string& url, const std::string& host_header) {
+void HTTPClient::setShare(std::shared_ptr<CurlShare> share) {
+    share_ = std::move(share);
+    if (curl_) {
+        curl_easy_setopt(curl_, CURLOPT_SHARE, share_ ? share_->handle() : nullptr);
+    }
+}
+
+bool HTTPClient::ensureHandle() {
+    if (curl_) {
+        return true;
+    }
+
+    curl_ = curl_easy_init();
+    if (!curl_) {
+        return false;
+    }
+
+    // Options that stay the same for every request on this handle
+    curl_easy_setopt(curl_, CURLOPT_NOBODY, 1L); // HEAD request
+    curl_easy_setopt(curl_, CURLOPT_FOLLOWLOCATION, 1L);
+    curl_easy_setopt(curl_, CURLOPT_USERAGENT, user_agent_.c_str());
+    curl_easy_setopt(curl_, CURLOPT_HEADERFUNCTION, CFHeaderParser::curlCallback);
+    curl_easy_setopt(curl_, CURLOPT_HEADERDATA, &header_parser_);
+    curl_easy_setopt(curl_, CURLOPT_NOSIGNAL, 1L);
+    if (share_) {
+        curl_easy_setopt(curl_, CURLOPT_SHARE, share_->handle());
+    }
+    return true;
+}
+
+HTTPResponse HTTPClient::head(const std::string& url, const std::string& host_header, const char* connect_to) {
     HTTPResponse response;
     response.success = false;
     response.status_code = 0;
     response.is_cache_hit = false;
 
-    CURL* curl = curl_easy_init();
-    if (!curl) {
+    if (!ensureHandle()) {
         response.error_message = "Failed to initialize CURL";
+        response.curl_code = CURLE_FAILED_INIT;
         return response;
     }
 
-    std::string headers_data;
-
-    // Set CURL options
-    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-    curl_easy_setopt(curl, CURLOPT_NOBODY, 1L); // HEAD request
-    curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
-    curl_easy_setopt(curl, CURLOPT_TIMEOUT, timeout_seconds_);
-    curl_easy_setopt(curl, CURLOPT_USERAGENT, user_agent_.c_str());
-    curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, header_callback);
-    curl_easy_setopt(curl, CURLOPT_HEADERDATA, &headers_data);
-    curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0L); // Skip SSL verification for CDN testing
-    curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 0L);
-
-    // Custom headers
-    struct curl_slist* chunk = nullptr;
-    if (!host_header.empty()) {
-        std::string host_line = "Host: " + host_header;
-        chunk = curl_slist_append(chunk, host_line.c_str());
-        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, chunk);
+    header_parser_.reset();
+
+    curl_easy_setopt(curl_, CURLOPT_URL, url.c_str());
+    curl_easy_setopt(curl_, CURLOPT_CONNECTTIMEOUT_MS, connect_timeout_ms_);
+    curl_easy_setopt(curl_, CURLOPT_TIMEOUT_MS, timeout_ms_);
+
+    // Custom headers, rebuilt only when the Host header changes
+    if (host_header != host_list_value_) {
+        if (host_list_) {
+            curl_slist_free_all(host_list_);
+            host_list_ = nullptr;
+        }
+        if (!host_header.empty()) {
+            std::string host_line = "Host: " + host_header;
+            host_list_ = curl_slist_append(nullptr, host_line.c_str());
+        }
+        host_list_value_ = host_header;
+        curl_easy_setopt(curl_, CURLOPT_HTTPHEADER, host_list_);
+    }
+
+    // A URL rewritten to the edge IP can't match the certificate, so TLS is
+    // only verified for pinned connections, which keep the real hostname
+    long verify = connect_to ? 1L : 0L;
+    curl_easy_setopt(curl_, CURLOPT_SSL_VERIFYPEER, verify);
+    curl_easy_setopt(curl_, CURLOPT_SSL_VERIFYHOST, verify * 2);
+
+    // Connection pinning; the entry is only read during this call
+    if (connect_to) {
+        connect_to_node_.data = const_cast<char*>(connect_to);
+        connect_to_node_.next = nullptr;
+        curl_easy_setopt(curl_, CURLOPT_CONNECT_TO, &connect_to_node_);
+        connect_to_set_ = true;
+    } else if (connect_to_set_) {
+        curl_easy_setopt(curl_, CURLOPT_CONNECT_TO, nullptr);
+        connect_to_set_ = false;
     }
 
     // Perform the request
-    CURLcode res = curl_easy_perform(curl);
+    CURLcode res = curl_easy_perform(curl_);
+    response.curl_code = res;
 
     if (res != CURLE_OK) {
         response.error_message = curl_easy_strerror(res);
@@ -74,64 +191,22 @@ HTTPResponse HTTPClient::head(const std::string& url, const std::string& host_he
 
         // Get response code
         long response_code;
-        curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &response_code);
+        curl_easy_getinfo(curl_, CURLINFO_RESPONSE_CODE, &response_code);
         response.status_code = static_cast<int>(response_code);
 
-        // Parse headers for CF-Cache-Status
-        size_t pos = headers_data.find("CF-Cache-Status:");
-        if (pos != std::string::npos) {
-            size_t start = pos + 16; // Length of "CF-Cache-Status:"
-            size_t end = headers_data.find("\r\n", start);
-            if (end != std::string::npos) {
-                response.cf_cache_status = headers_data.substr(start, end - start);
-                // Trim whitespace
-                response.cf_cache_status.erase(0, response.cf_cache_status.find_first_not_of(" \t"));
-                response.cf_cache_status.erase(response.cf_cache_status.find_last_not_of(" \t") + 1);
-
-                // Determine if it's a cache hit
-                response.is_cache_hit = (response.cf_cache_status == "HIT");
-            }
-        }
-
-        // Parse CF-Ray header
-        pos = headers_data.find("CF-Ray:");
-        if (pos != std::string::npos) {
-            size_t start = pos + 7; // Length of "CF-Ray:"
-            size_t end = headers_data.find("\r\n", start);
-            if (end != std::string::npos) {
-                response.cf_ray = headers_data.substr(start, end - start);
-                // Trim whitespace
-                response.cf_ray.erase(0, response.cf_ray.find_first_not_of(" \t"));
-                response.cf_ray.erase(response.cf_ray.find_last_not_of(" \t") + 1);
-
-                // Extract IATA code (last 3 characters after dash)
-                // Format: "8428f15b8a9c1234-SJC"
-                size_t dash_pos = response.cf_ray.find_last_of('-');
-                if (dash_pos != std::string::npos && dash_pos + 3 < response.cf_ray.length()) {
-                    response.cf_iata_code = response.cf_ray.substr(dash_pos + 1, 3);
-                }
-            }
-        }
-
-        // Parse CF-IPCountry header (optional)
-        pos = headers_data.find("CF-IPCountry:");
-        if (pos != std::string::npos) {
-            size_t start = pos + 13; // Length of "CF-IPCountry:"
-            size_t end = headers_data.find("\r\n", start);
-            if (end != std::string::npos) {
-                response.cf_ip_country = headers_data.substr(start, end - start);
-                // Trim whitespace
-                response.cf_ip_country.erase(0, response.cf_ip_country.find_first_not_of(" \t"));
-                response.cf_ip_country.erase(response.cf_ip_country.find_last_not_of(" \t") + 1);
-            }
-        }
-    }
-
-    if (chunk) {
-        curl_slist_free_all(chunk);
+        curl_off_t connect_us = 0, tls_us = 0, ttfb_us = 0, total_us = 0;
+        curl_easy_getinfo(curl_, CURLINFO_CONNECT_TIME_T, &connect_us);
+        curl_easy_getinfo(curl_, CURLINFO_APPCONNECT_TIME_T, &tls_us);
+        curl_easy_getinfo(curl_, CURLINFO_STARTTRANSFER_TIME_T, &ttfb_us);
+        curl_easy_getinfo(curl_, CURLINFO_TOTAL_TIME_T, &total_us);
+        response.connect_time_us = static_cast<long>(connect_us);
+        response.tls_time_us = static_cast<long>(tls_us);
+        response.ttfb_us = static_cast<long>(ttfb_us);
+        response.total_time_us = static_cast<long>(total_us);
+
+        header_parser_.apply(response);
     }
 
-    curl_easy_cleanup(curl);
     return response;
 }
 
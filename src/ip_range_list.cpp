@@ -0,0 +1,145 @@
+#include "ip_range_list.h"
+#include "cidr_utils.h"
+#include <algorithm>
+
+namespace cfpinner {
+
+void IPRangeList::push(Segment segment) {
+    if (segment.count == 0) {
+        return;
+    }
+    segment.start = size_;
+    size_ += segment.count;
+    segments_.push_back(segment);
+}
+
+bool IPRangeList::addRange(const std::string& cidr, size_t max_ips) {
+    uint32_t base_ip;
+    int prefix_len;
+    if (!CIDRUtils::parseCIDR(cidr, base_ip, prefix_len)) {
+        return false;
+    }
+
+    // 2^32 hosts would not fit the 32-bit counts
+    if (prefix_len == 0) {
+        return false;
+    }
+
+    uint32_t total_hosts = CIDRUtils::getHostCount(prefix_len);
+
+    Segment segment = {};
+    segment.base = base_ip;
+    segment.total_hosts = total_hosts;
+    if (max_ips != SIZE_MAX && total_hosts > max_ips) {
+        // Evenly spread samples over the range
+        segment.kind = Segment::SAMPLED;
+        segment.step = static_cast<uint32_t>(total_hosts / max_ips);
+        segment.count = static_cast<uint32_t>(max_ips);
+    } else {
+        // Every host, without network and broadcast address for ranges > /31
+        segment.kind = Segment::HOSTS;
+        bool skip_ends = prefix_len < 31;
+        segment.first = skip_ends ? 1 : 0;
+        segment.count = skip_ends ? total_hosts - 2 : total_hosts;
+    }
+    push(segment);
+    return true;
+}
+
+void IPRangeList::addAddress(uint32_t ip) {
+    // Consecutive single addresses share one LIST segment
+    if (!segments_.empty() && segments_.back().kind == Segment::LIST &&
+        segments_.back().base + segments_.back().count == addresses_.size()) {
+        addresses_.push_back(ip);
+        segments_.back().count++;
+        size_++;
+        return;
+    }
+
+    Segment segment = {};
+    segment.kind = Segment::LIST;
+    segment.base = static_cast<uint32_t>(addresses_.size());
+    segment.count = 1;
+    addresses_.push_back(ip);
+    push(segment);
+}
+
+uint32_t IPRangeList::addressIn(const Segment& segment, uint32_t offset) const {
+    switch (segment.kind) {
+        case Segment::HOSTS:
+            return segment.base + segment.first + offset;
+
+        case Segment::SAMPLED: {
+            uint32_t position = offset * segment.step;
+
+            // Vary the position inside each step so samples are not always
+            // the first address of a subnet
+            if (offset > 0 && segment.step > 4) {
+                position += offset % 4;
+            }
+
+            // Skip network address (first) and broadcast address (last)
+            if (segment.total_hosts > 2) {
+                position = std::max<uint32_t>(position, 1);
+                position = std::min<uint32_t>(position, segment.total_hosts - 2);
+            }
+            return segment.base + position;
+        }
+
+        case Segment::LIST:
+        default:
+            return addresses_[segment.base + offset];
+    }
+}
+
+uint32_t IPRangeList::at(size_t index) const {
+    // Last segment starting at or before index
+    auto it = std::upper_bound(segments_.begin(), segments_.end(), index,
+                               [](size_t value, const Segment& segment) { return value < segment.start; });
+    const Segment& segment = *(it - 1);
+    return addressIn(segment, static_cast<uint32_t>(index - segment.start));
+}
+
+std::string IPRangeList::addressAt(size_t index) const {
+    return CIDRUtils::uint32ToIp(at(index));
+}
+
+size_t IPRangeList::shardOf(uint32_t ip, size_t count) {
+    // Murmur3 finalizer: neighbouring addresses land on unrelated shards
+    uint32_t hash = ip;
+    hash ^= hash >> 16;
+    hash *= 0x85ebca6bU;
+    hash ^= hash >> 13;
+    hash *= 0xc2b2ae35U;
+    hash ^= hash >> 16;
+    return static_cast<size_t>(hash % count);
+}
+
+IPRangeList IPRangeList::shard(size_t index, size_t count) const {
+    IPRangeList part;
+    part.addresses_.reserve(size_ / std::max<size_t>(count, 1) + 1);
+
+    Cursor cursor(*this);
+    uint32_t ip;
+    while (cursor.next(ip)) {
+        if (shardOf(ip, count) == index) {
+            part.addAddress(ip);
+        }
+    }
+    return part;
+}
+
+bool IPRangeList::Cursor::next(uint32_t& ip) {
+    while (segment_ < list_.segments_.size()) {
+        const Segment& segment = list_.segments_[segment_];
+        if (offset_ < segment.count) {
+            ip = list_.addressIn(segment, offset_++);
+            return true;
+        }
+        segment_++;
+        offset_ = 0;
+    }
+    return false;
+}
+
+} // namespace cfpinner
@@ -0,0 +1,215 @@
+#include "metrics_exporter.h"
+#include "result_store.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include <cstdio>
+#include <ctime>
+#include <sys/stat.h>
+#include <curl/curl.h>
+
+namespace cfpinner {
+
+static const char* PHASE_NAMES[] = {"connect", "tls", "ttfb", "total"};
+static const double QUANTILES[] = {0.5, 0.9, 0.99};
+
+// Label value of a cache status (a missing header is "NONE")
+static const char* cacheStatusLabel(size_t status) {
+    return status == static_cast<size_t>(CacheStatus::NONE) ? "NONE"
+                                                             : ResultStore::cacheStatusName(static_cast<CacheStatus>(status));
+}
+
+// Replace path atomically with content
+static bool writeFileAtomic(const std::string& path, const std::string& content) {
+    std::string temp_path = path + ".tmp";
+    std::ofstream file(temp_path, std::ios::trunc);
+    if (!file.is_open()) {
+        return false;
+    }
+    file << content;
+    file.close();
+    if (!file || std::rename(temp_path.c_str(), path.c_str()) != 0) {
+        std::remove(temp_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+MetricsExporter::MetricsExporter(const ScanMetrics& metrics, const std::string& directory,
+                                 const std::string& scan, unsigned interval_s)
+    : metrics_(metrics), directory_(directory), scan_(scan), interval_s_(std::max(interval_s, 1u)),
+      running_(false), last_completed_(0), last_uptime_s_(0) {
+    struct stat st;
+    if (stat(directory_.c_str(), &st) != 0) {
+        mkdir(directory_.c_str(), 0755);
+    }
+}
+
+MetricsExporter::~MetricsExporter() {
+    stop();
+}
+
+void MetricsExporter::start() {
+    if (running_) {
+        return;
+    }
+    running_ = true;
+    std::cout << "Writing scan metrics to " << prometheusPath() << " and " << jsonPath()
+              << " every " << interval_s_ << "s" << std::endl;
+    thread_ = std::thread([this]() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (running_) {
+            if (wake_.wait_for(lock, std::chrono::seconds(interval_s_), [this]() { return !running_; })) {
+                break;
+            }
+            lock.unlock();
+            exportNow();
+            lock.lock();
+        }
+    });
+}
+
+void MetricsExporter::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_) {
+            return;
+        }
+        running_ = false;
+    }
+    wake_.notify_all();
+    thread_.join();
+    exportNow();
+}
+
+void MetricsExporter::exportNow() {
+    ScanMetrics::Snapshot snapshot = metrics_.snapshot();
+    double elapsed = snapshot.uptime_s - last_uptime_s_;
+    double rate = elapsed > 0 ? (snapshot.completed - last_completed_) / elapsed : 0;
+    last_completed_ = snapshot.completed;
+    last_uptime_s_ = snapshot.uptime_s;
+
+    if (!write(snapshot, rate)) {
+        std::cerr << "Failed to write metrics to " << directory_ << std::endl;
+    }
+}
+
+bool MetricsExporter::write(const ScanMetrics::Snapshot& snapshot, double rate) const {
+    bool prometheus_ok = writeFileAtomic(prometheusPath(), formatPrometheus(snapshot, rate));
+    bool json_ok = writeFileAtomic(jsonPath(), formatJSON(snapshot, rate));
+    return prometheus_ok && json_ok;
+}
+
+std::string MetricsExporter::formatPrometheus(const ScanMetrics::Snapshot& snapshot, double rate) const {
+    std::ostringstream out;
+    std::string scan = "scan=\"" + scan_ + "\"";
+
+    auto metric = [&](const char* name, const char* type, const char* help) {
+        out << "# HELP " << name << " " << help << "\n";
+        out << "# TYPE " << name << " " << type << "\n";
+    };
+
+    metric("cfpinner_scan_uptime_seconds", "gauge", "Seconds since the scan started");
+    out << "cfpinner_scan_uptime_seconds{" << scan << "} " << snapshot.uptime_s << "\n";
+
+    metric("cfpinner_probes_started_total", "counter", "Probes handed to the transport, retries included");
+    out << "cfpinner_probes_started_total{" << scan << "} " << snapshot.started << "\n";
+
+    metric("cfpinner_probes_completed_total", "counter", "Probes that finished, successfully or not");
+    out << "cfpinner_probes_completed_total{" << scan << "} " << snapshot.completed << "\n";
+
+    metric("cfpinner_probes_retried_total", "counter", "Failed probes deferred to a retry round");
+    out << "cfpinner_probes_retried_total{" << scan << "} " << snapshot.retried << "\n";
+
+    metric("cfpinner_probes_in_flight", "gauge", "Probes started but not finished");
+    out << "cfpinner_probes_in_flight{" << scan << "} " << snapshot.inFlight() << "\n";
+
+    metric("cfpinner_probe_rate", "gauge", "Probes finished per second since the previous export");
+    out << "cfpinner_probe_rate{" << scan << "} " << rate << "\n";
+
+    metric("cfpinner_results_total", "counter", "Successful probes by CF-Cache-Status");
+    for (size_t i = 0; i < ScanMetrics::CACHE_STATUSES; i++) {
+        out << "cfpinner_results_total{" << scan << ",cache_status=\"" << cacheStatusLabel(i) << "\"} "
+            << snapshot.by_cache_status[i] << "\n";
+    }
+
+    metric("cfpinner_errors_total", "counter", "Failed probes by curl error code");
+    for (size_t code = 0; code < ScanMetrics::CURL_CODES; code++) {
+        if (snapshot.by_curl_code[code] == 0) {
+            continue;
+        }
+        out << "cfpinner_errors_total{" << scan << ",curl_code=\"" << code << "\",error=\""
+            << ResultStore::errorClassName(ResultStore::classifyError(static_cast<int>(code))) << "\"} "
+            << snapshot.by_curl_code[code] << "\n";
+    }
+
+    metric("cfpinner_probe_latency_seconds", "summary", "Probe latency by phase");
+    for (size_t p = 0; p < static_cast<size_t>(LatencyPhase::COUNT); p++) {
+        const ScanMetrics::Latency& latency = snapshot.latency[p];
+        std::string labels = scan + ",phase=\"" + PHASE_NAMES[p] + "\"";
+        for (double q : QUANTILES) {
+            out << "cfpinner_probe_latency_seconds{" << labels << ",quantile=\"" << q << "\"} "
+                << latency.percentile(q) / 1e6 << "\n";
+        }
+        out << "cfpinner_probe_latency_seconds_sum{" << labels << "} " << latency.sum_us / 1e6 << "\n";
+        out << "cfpinner_probe_latency_seconds_count{" << labels << "} " << latency.count << "\n";
+    }
+
+    return out.str();
+}
+
+std::string MetricsExporter::formatJSON(const ScanMetrics::Snapshot& snapshot, double rate) const {
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(3);
+
+    out << "{\n";
+    out << "  \"scan\": \"" << scan_ << "\",\n";
+    out << "  \"timestamp\": " << time(nullptr) << ",\n";
+    out << "  \"uptime_s\": " << snapshot.uptime_s << ",\n";
+    out << "  \"probes\": {\"started\": " << snapshot.started << ", \"completed\": " << snapshot.completed
+        << ", \"succeeded\": " << snapshot.succeeded << ", \"errors\": " << snapshot.errors()
+        << ", \"retried\": " << snapshot.retried << ", \"in_flight\": " << snapshot.inFlight()
+        << ", \"per_second\": " << rate << "},\n";
+
+    out << "  \"cache_status\": {";
+    for (size_t i = 0; i < ScanMetrics::CACHE_STATUSES; i++) {
+        out << (i ? ", " : "") << "\"" << cacheStatusLabel(i) << "\": "
+            << snapshot.by_cache_status[i];
+    }
+    out << "},\n";
+
+    out << "  \"errors\": [";
+    bool first = true;
+    for (size_t code = 0; code < ScanMetrics::CURL_CODES; code++) {
+        if (snapshot.by_curl_code[code] == 0) {
+            continue;
+        }
+        out << (first ? "" : ", ") << "{\"curl_code\": " << code << ", \"error\": \""
+            << ResultStore::errorClassName(ResultStore::classifyError(static_cast<int>(code)))
+            << "\", \"message\": \"" << curl_easy_strerror(static_cast<CURLcode>(code))
+            << "\", \"count\": " << snapshot.by_curl_code[code] << "}";
+        first = false;
+    }
+    out << "],\n";
+
+    // Latencies in milliseconds
+    out << "  \"latency_ms\": {\n";
+    for (size_t p = 0; p < static_cast<size_t>(LatencyPhase::COUNT); p++) {
+        const ScanMetrics::Latency& latency = snapshot.latency[p];
+        out << "    \"" << PHASE_NAMES[p] << "\": {\"count\": " << latency.count
+            << ", \"mean\": " << (latency.count ? latency.sum_us / 1000.0 / latency.count : 0.0)
+            << ", \"p50\": " << latency.percentile(0.5) / 1000.0
+            << ", \"p90\": " << latency.percentile(0.9) / 1000.0
+            << ", \"p99\": " << latency.percentile(0.99) / 1000.0
+            << ", \"max\": " << latency.max_us / 1000.0 << "}"
+            << (p + 1 < static_cast<size_t>(LatencyPhase::COUNT) ? "," : "") << "\n";
+    }
+    out << "  }\n";
+    out << "}\n";
+
+    return out.str();
+}
+
+} // namespace cfpinner
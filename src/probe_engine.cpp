@@ -0,0 +1,429 @@
+#include "probe_engine.h"
+#include <iostream>
+#include <algorithm>
+#include <stdexcept>
+#include <chrono>
+#include <cstdlib>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+namespace cfpinner {
+
+// State owned by a single in-flight transfer
+struct ProbeEngine::Transfer {
+    ProbeRequest request;
+    CFHeaderParser header_parser;
+    std::string url;                   // Only used when the URL is rewritten
+    struct curl_slist host_node;       // Points at the target's prebuilt Host line
+    std::string connect_to;            // Backing store for connect_to_node
+    struct curl_slist connect_to_node;
+};
+
+ProbeTarget ProbeTarget::fromURL(const std::string& url, bool pin_connect, const std::string& host_override) {
+    ProbeTarget target;
+    target.pin_connect = pin_connect;
+    target.url = url;
+    target.scheme = "https";
+
+    size_t host_start = 0;
+    size_t scheme_end = url.find("://");
+    if (scheme_end != std::string::npos) {
+        target.scheme = url.substr(0, scheme_end);
+        host_start = scheme_end + 3;
+    } else {
+        target.url = "https://" + url;
+    }
+
+    size_t path_start = url.find('/', host_start);
+    std::string authority = url.substr(host_start, path_start == std::string::npos ? std::string::npos : path_start - host_start);
+    target.path = path_start == std::string::npos ? "/" : url.substr(path_start);
+
+    target.port = (target.scheme == "http") ? 80 : 443;
+    size_t colon = authority.rfind(':');
+    if (colon != std::string::npos && authority.find(']') == std::string::npos) {
+        target.port = std::atoi(authority.c_str() + colon + 1);
+        target.url_host = authority.substr(0, colon);
+    } else {
+        target.url_host = authority;
+    }
+
+    target.host = host_override.empty() ? authority : host_override;
+    target.host_line = "Host: " + target.host;
+    return target;
+}
+
+std::string ProbeTarget::urlForIP(const std::string& ip_address) const {
+    std::string result;
+    result.reserve(scheme.size() + 3 + ip_address.size() + 6 + path.size());
+    result.append(scheme).append("://").append(ip_address);
+    if (port != (scheme == "http" ? 80 : 443)) {
+        result.append(":").append(std::to_string(port));
+    }
+    result.append(path);
+    return result;
+}
+
+std::string ProbeTarget::connectTo(const std::string& ip_address) const {
+    std::string port_text = std::to_string(port);
+    std::string result;
+    result.reserve(url_host.size() + ip_address.size() + 2 * port_text.size() + 3);
+    result.append(url_host).append(":").append(port_text).append(":");
+    result.append(ip_address).append(":").append(port_text);
+    return result;
+}
+
+// Failures that get more frequent when we push too many probes at once
+static bool isCongestionError(CURLcode code) {
+    return HTTPClient::isTransientError(code) || code == CURLE_COULDNT_CONNECT;
+}
+
+static long long nowMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+size_t ProbeEngine::raiseFileLimit() {
+    struct rlimit rl;
+    if (getrlimit(RLIMIT_NOFILE, &rl) != 0) {
+        return 1024;
+    }
+    if (rl.rlim_cur < rl.rlim_max) {
+        rl.rlim_cur = rl.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &rl);
+        getrlimit(RLIMIT_NOFILE, &rl);
+    }
+    return static_cast<size_t>(rl.rlim_cur);
+}
+
+ProbeEngine::ProbeEngine(size_t max_in_flight)
+    : multi_(nullptr),
+      epoll_fd_(-1),
+      timer_deadline_ms_(-1),
+      max_in_flight_(1),
+      in_flight_(0),
+      controller_(nullptr),
+      multiplex_(false),
+      connect_timeout_ms_(0),
+      timeout_ms_(5000),
+      user_agent_("CFPinner/1.0") {
+    HTTPClient::globalInit();
+
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd_ < 0) {
+        throw std::runtime_error("Failed to create epoll instance");
+    }
+
+    multi_ = curl_multi_init();
+    if (!multi_) {
+        close(epoll_fd_);
+        throw std::runtime_error("Failed to initialize CURL multi handle");
+    }
+
+    curl_multi_setopt(multi_, CURLMOPT_SOCKETFUNCTION, socketCallback);
+    curl_multi_setopt(multi_, CURLMOPT_SOCKETDATA, this);
+    curl_multi_setopt(multi_, CURLMOPT_TIMERFUNCTION, timerCallback);
+    curl_multi_setopt(multi_, CURLMOPT_TIMERDATA, this);
+    curl_multi_setopt(multi_, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+
+    setMaxInFlight(max_in_flight);
+}
+
+ProbeEngine::~ProbeEngine() {
+    for (CURL* easy : idle_handles_) {
+        curl_easy_cleanup(easy);
+    }
+    curl_multi_cleanup(multi_);
+    close(epoll_fd_);
+}
+
+void ProbeEngine::setTimeout(int timeout_seconds) {
+    setTimeoutMs(0, timeout_seconds * 1000L);
+}
+
+void ProbeEngine::setTimeoutMs(long connect_timeout_ms, long timeout_ms) {
+    connect_timeout_ms_ = connect_timeout_ms;
+    timeout_ms_ = timeout_ms;
+}
+
+void ProbeEngine::setUserAgent(const std::string& user_agent) {
+    user_agent_ = user_agent;
+}
+
+void ProbeEngine::setShare(std::shared_ptr<CurlShare> share) {
+    share_ = std::move(share);
+}
+
+void ProbeEngine::setMultiplex(bool enabled) {
+    multiplex_ = enabled;
+
+    // One connection per edge; extra probes wait for it instead of dialing again
+    curl_multi_setopt(multi_, CURLMOPT_MAX_HOST_CONNECTIONS, enabled ? 1L : 0L);
+}
+
+void ProbeEngine::setMaxInFlight(size_t max_in_flight) {
+    // Leave some descriptors for the epoll instance, output files and stdio
+    size_t fd_limit = raiseFileLimit();
+    size_t usable = fd_limit > 64 ? fd_limit - 64 : 1;
+
+    if (max_in_flight > usable) {
+        std::cerr << "Warning: limiting in-flight probes to " << usable
+                  << " (open file limit is " << fd_limit << ")" << std::endl;
+        max_in_flight = usable;
+    }
+    max_in_flight_ = max_in_flight > 0 ? max_in_flight : 1;
+}
+
+size_t ProbeEngine::getMaxInFlight() const {
+    return max_in_flight_;
+}
+
+void ProbeEngine::setConcurrencyController(ConcurrencyController* controller) {
+    controller_ = controller;
+}
+
+size_t ProbeEngine::inFlight() const {
+    return in_flight_;
+}
+
+void ProbeEngine::submit(ProbeRequest request) {
+    queue_.push_back(std::move(request));
+}
+
+int ProbeEngine::socketCallback(CURL* /*easy*/, curl_socket_t fd, int what, void* userp, void* socketp) {
+    ProbeEngine* engine = static_cast<ProbeEngine*>(userp);
+
+    if (what == CURL_POLL_REMOVE) {
+        // The socket may already be closed, in which case epoll dropped it itself
+        epoll_ctl(engine->epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+        return 0;
+    }
+
+    struct epoll_event ev = {};
+    ev.data.fd = fd;
+    if (what == CURL_POLL_IN || what == CURL_POLL_INOUT) {
+        ev.events |= EPOLLIN;
+    }
+    if (what == CURL_POLL_OUT || what == CURL_POLL_INOUT) {
+        ev.events |= EPOLLOUT;
+    }
+
+    if (socketp) {
+        epoll_ctl(engine->epoll_fd_, EPOLL_CTL_MOD, fd, &ev);
+    } else {
+        // Mark the socket as registered so later calls use EPOLL_CTL_MOD
+        epoll_ctl(engine->epoll_fd_, EPOLL_CTL_ADD, fd, &ev);
+        curl_multi_assign(engine->multi_, fd, engine);
+    }
+    return 0;
+}
+
+int ProbeEngine::timerCallback(CURLM* /*multi*/, long timeout_ms, void* userp) {
+    ProbeEngine* engine = static_cast<ProbeEngine*>(userp);
+    engine->timer_deadline_ms_ = timeout_ms < 0 ? -1 : nowMs() + timeout_ms;
+    return 0;
+}
+
+bool ProbeEngine::startTransfer(ProbeRequest& request) {
+    CURL* easy;
+    if (!idle_handles_.empty()) {
+        easy = idle_handles_.back();
+        idle_handles_.pop_back();
+        curl_easy_reset(easy);
+    } else {
+        easy = curl_easy_init();
+        if (!easy) {
+            return false;
+        }
+    }
+
+    Transfer* transfer = new Transfer();
+    transfer->request = std::move(request);
+
+    // curl only reads header lists, so they can point at storage we own
+    // instead of being allocated with curl_slist_append for every probe
+    const ProbeTarget& target = *transfer->request.target;
+    if (target.pin_connect) {
+        // Keep the real hostname (correct SNI) and route the connection to the edge
+        transfer->connect_to = target.connectTo(transfer->request.ip_address);
+        transfer->connect_to_node.data = const_cast<char*>(transfer->connect_to.c_str());
+        transfer->connect_to_node.next = nullptr;
+        curl_easy_setopt(easy, CURLOPT_URL, target.url.c_str());
+        curl_easy_setopt(easy, CURLOPT_CONNECT_TO, &transfer->connect_to_node);
+    } else {
+        transfer->url = target.urlForIP(transfer->request.ip_address);
+        curl_easy_setopt(easy, CURLOPT_URL, transfer->url.c_str());
+    }
+    if (target.needsHostHeader()) {
+        transfer->host_node.data = const_cast<char*>(target.host_line.c_str());
+        transfer->host_node.next = nullptr;
+        curl_easy_setopt(easy, CURLOPT_HTTPHEADER, &transfer->host_node);
+    }
+
+    curl_easy_setopt(easy, CURLOPT_NOBODY, 1L); // HEAD request
+    curl_easy_setopt(easy, CURLOPT_FOLLOWLOCATION, 1L);
+    const ProbeRequest& probe = transfer->request;
+    curl_easy_setopt(easy, CURLOPT_CONNECTTIMEOUT_MS,
+                     probe.connect_timeout_ms >= 0 ? probe.connect_timeout_ms : connect_timeout_ms_);
+    curl_easy_setopt(easy, CURLOPT_TIMEOUT_MS, probe.timeout_ms >= 0 ? probe.timeout_ms : timeout_ms_);
+    curl_easy_setopt(easy, CURLOPT_USERAGENT, user_agent_.c_str());
+    curl_easy_setopt(easy, CURLOPT_HEADERFUNCTION, CFHeaderParser::curlCallback);
+    curl_easy_setopt(easy, CURLOPT_HEADERDATA, &transfer->header_parser);
+    // Only pinned connections keep the hostname the certificate is for
+    curl_easy_setopt(easy, CURLOPT_SSL_VERIFYPEER, target.pin_connect ? 1L : 0L);
+    curl_easy_setopt(easy, CURLOPT_SSL_VERIFYHOST, target.pin_connect ? 2L : 0L);
+    curl_easy_setopt(easy, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(easy, CURLOPT_PRIVATE, transfer);
+    if (share_) {
+        curl_easy_setopt(easy, CURLOPT_SHARE, share_->handle());
+    }
+    if (multiplex_) {
+        curl_easy_setopt(easy, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2TLS);
+        curl_easy_setopt(easy, CURLOPT_PIPEWAIT, 1L);
+    }
+
+    if (curl_multi_add_handle(multi_, easy) != CURLM_OK) {
+        request = std::move(transfer->request);
+        delete transfer;
+        curl_easy_cleanup(easy);
+        return false;
+    }
+
+    in_flight_++;
+    return true;
+}
+
+void ProbeEngine::finishTransfers(const ProbeCallback& on_complete) {
+    int msgs_left = 0;
+    CURLMsg* msg;
+
+    while ((msg = curl_multi_info_read(multi_, &msgs_left)) != nullptr) {
+        if (msg->msg != CURLMSG_DONE) {
+            continue;
+        }
+
+        CURL* easy = msg->easy_handle;
+        CURLcode res = msg->data.result;
+
+        Transfer* transfer = nullptr;
+        curl_easy_getinfo(easy, CURLINFO_PRIVATE, &transfer);
+
+        HTTPResponse response;
+        response.success = false;
+        response.status_code = 0;
+        response.is_cache_hit = false;
+        response.curl_code = res;
+
+        if (res != CURLE_OK) {
+            response.error_message = curl_easy_strerror(res);
+        } else {
+            response.success = true;
+
+            long response_code;
+            curl_easy_getinfo(easy, CURLINFO_RESPONSE_CODE, &response_code);
+            response.status_code = static_cast<int>(response_code);
+
+            curl_off_t connect_us = 0, tls_us = 0, ttfb_us = 0, total_us = 0;
+            curl_easy_getinfo(easy, CURLINFO_CONNECT_TIME_T, &connect_us);
+            curl_easy_getinfo(easy, CURLINFO_APPCONNECT_TIME_T, &tls_us);
+            curl_easy_getinfo(easy, CURLINFO_STARTTRANSFER_TIME_T, &ttfb_us);
+            curl_easy_getinfo(easy, CURLINFO_TOTAL_TIME_T, &total_us);
+            response.connect_time_us = static_cast<long>(connect_us);
+            response.tls_time_us = static_cast<long>(tls_us);
+            response.ttfb_us = static_cast<long>(ttfb_us);
+            response.total_time_us = static_cast<long>(total_us);
+
+            transfer->header_parser.apply(response);
+        }
+
+        curl_multi_remove_handle(multi_, easy);
+        idle_handles_.push_back(easy);
+        in_flight_--;
+
+        if (controller_) {
+            controller_->record(response.success, isCongestionError(res), response.total_time_us);
+        }
+
+        on_complete(transfer->request, response);
+        delete transfer;
+    }
+}
+
+void ProbeEngine::driveTimeouts(const ProbeCallback& on_complete) {
+    if (timer_deadline_ms_ >= 0 && nowMs() >= timer_deadline_ms_) {
+        int running = 0;
+        timer_deadline_ms_ = -1;
+        curl_multi_socket_action(multi_, CURL_SOCKET_TIMEOUT, 0, &running);
+    }
+    finishTransfers(on_complete);
+}
+
+void ProbeEngine::run(const ProbeCallback& on_complete) {
+    run(ProbeSource(), on_complete);
+}
+
+void ProbeEngine::run(const ProbeSource& source, const ProbeCallback& on_complete) {
+    const int max_events = 256;
+    struct epoll_event events[max_events];
+    bool source_done = !source;
+    int running = 0;
+
+    while (true) {
+        // Fill free slots, queued probes first
+        size_t limit = controller_ ? std::min(controller_->limit(), max_in_flight_) : max_in_flight_;
+        while (in_flight_ < limit) {
+            ProbeRequest request;
+            if (!queue_.empty()) {
+                request = std::move(queue_.front());
+                queue_.pop_front();
+            } else if (!source_done && source(request)) {
+                // Got a new probe from the source
+            } else {
+                source_done = true;
+                break;
+            }
+
+            if (!startTransfer(request)) {
+                HTTPResponse response;
+                response.success = false;
+                response.status_code = 0;
+                response.is_cache_hit = false;
+                response.error_message = "Failed to initialize CURL";
+                response.curl_code = CURLE_FAILED_INIT;
+                on_complete(request, response);
+            }
+        }
+
+        if (in_flight_ == 0 && queue_.empty() && source_done) {
+            break;
+        }
+
+        // Sleep until the next socket event or the next curl timeout
+        int wait_ms = 1000;
+        if (timer_deadline_ms_ >= 0) {
+            long long remaining = timer_deadline_ms_ - nowMs();
+            wait_ms = remaining > 0 ? static_cast<int>(std::min(remaining, 1000LL)) : 0;
+        }
+
+        int n = wait_ms > 0 ? epoll_wait(epoll_fd_, events, max_events, wait_ms) : 0;
+
+        for (int i = 0; i < n; i++) {
+            int mask = 0;
+            if (events[i].events & EPOLLIN) {
+                mask |= CURL_CSELECT_IN;
+            }
+            if (events[i].events & EPOLLOUT) {
+                mask |= CURL_CSELECT_OUT;
+            }
+            if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                mask |= CURL_CSELECT_ERR;
+            }
+            curl_multi_socket_action(multi_, events[i].data.fd, mask, &running);
+        }
+
+        // Busy sockets must not starve timeouts of the idle ones
+        driveTimeouts(on_complete);
+    }
+}
+
+} // namespace cfpinner
@@ -0,0 +1,89 @@
+#include "result_pipeline.h"
+#include "http_client.h"
+#include "probe_engine.h"
+#include "cidr_utils.h"
+#include <chrono>
+#include <cstring>
+
+namespace cfpinner {
+
+static void copyField(char* dest, size_t size, const std::string& value) {
+    size_t length = value.size() < size - 1 ? value.size() : size - 1;
+    std::memcpy(dest, value.data(), length);
+    dest[length] = '\0';
+}
+
+ResultEvent ResultEvent::fromProbe(const ProbeRequest& request, const HTTPResponse& response) {
+    ResultEvent event;
+    event.ip = CIDRUtils::ipToUint32(request.ip_address);
+    event.url_index = static_cast<uint16_t>(request.url_index);
+    event.status_code = static_cast<uint16_t>(response.status_code);
+    event.curl_code = response.curl_code;
+    event.connect_time_us = static_cast<uint32_t>(response.connect_time_us);
+    event.success = response.success;
+    event.is_hit = response.is_cache_hit;
+    copyField(event.headers.cache_status, sizeof(event.headers.cache_status), response.cf_cache_status);
+    copyField(event.headers.ray, sizeof(event.headers.ray), response.cf_ray);
+    copyField(event.headers.iata_code, sizeof(event.headers.iata_code), response.cf_iata_code);
+    copyField(event.headers.ip_country, sizeof(event.headers.ip_country), response.cf_ip_country);
+    return event;
+}
+
+const char* ResultEvent::errorMessage() const {
+    return curl_easy_strerror(static_cast<CURLcode>(curl_code));
+}
+
+ResultPipeline::ResultPipeline(Handler handler, IdleHandler on_idle, size_t capacity)
+    : ring_(capacity),
+      handler_(std::move(handler)),
+      on_idle_(std::move(on_idle)),
+      done_(false) {
+    consumer_ = std::thread(&ResultPipeline::consume, this);
+}
+
+ResultPipeline::~ResultPipeline() {
+    finish();
+}
+
+void ResultPipeline::publish(const ResultEvent& event) {
+    ring_.push(event);
+}
+
+void ResultPipeline::finish() {
+    if (consumer_.joinable()) {
+        done_.store(true, std::memory_order_release);
+        consumer_.join();
+    }
+}
+
+void ResultPipeline::consume() {
+    ResultEvent event;
+    bool handled = false;
+    while (true) {
+        if (ring_.tryPop(event)) {
+            handler_(event);
+            handled = true;
+            continue;
+        }
+
+        if (handled && on_idle_) {
+            on_idle_();
+        }
+        handled = false;
+
+        // Producers have stopped; one last look picks up anything published before done_
+        if (done_.load(std::memory_order_acquire)) {
+            while (ring_.tryPop(event)) {
+                handler_(event);
+                handled = true;
+            }
+            if (handled && on_idle_) {
+                on_idle_();
+            }
+            return;
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(500));
+    }
+}
+
+} // namespace cfpinner
@@ -0,0 +1,372 @@
+#include "result_sink.h"
+#include "result_pipeline.h"
+#include "result_store.h"
+#include "cdn_tracker.h"
+#include "cidr_utils.h"
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <strings.h>
+
+namespace cfpinner {
+
+static const char RESULTS_MAGIC[8] = {'C', 'F', 'P', 'R', 'S', 'L', 'T', '1'};
+static const uint32_t RESULTS_VERSION = 1;
+
+struct ResultFileHeader {
+    char magic[8];         // "CFPRSLT1"
+    uint32_t version;
+    uint32_t record_size;  // sizeof(ResultRecord)
+    uint32_t url_count;    // Entries in the URL table that follows
+    uint32_t reserved;
+    uint64_t created;      // Unix time
+};
+static_assert(sizeof(ResultFileHeader) == 32, "ResultFileHeader is part of the file format");
+
+// Length of the well-formed UTF-8 sequence starting at value[i], 0 if there is none
+static size_t utf8SequenceLength(const std::string& value, size_t i) {
+    unsigned char lead = static_cast<unsigned char>(value[i]);
+    size_t length;
+    unsigned char min_second = 0x80;
+    unsigned char max_second = 0xbf;
+    if (lead >= 0xc2 && lead <= 0xdf) {
+        length = 2;
+    } else if (lead >= 0xe0 && lead <= 0xef) {
+        length = 3;
+        if (lead == 0xe0) {
+            min_second = 0xa0;  // Overlong
+        } else if (lead == 0xed) {
+            max_second = 0x9f;  // Surrogates
+        }
+    } else if (lead >= 0xf0 && lead <= 0xf4) {
+        length = 4;
+        if (lead == 0xf0) {
+            min_second = 0x90;  // Overlong
+        } else if (lead == 0xf4) {
+            max_second = 0x8f;  // Above U+10FFFF
+        }
+    } else {
+        return 0;
+    }
+    if (i + length > value.size()) {
+        return 0;
+    }
+    for (size_t k = 1; k < length; k++) {
+        unsigned char c = static_cast<unsigned char>(value[i + k]);
+        if (c < (k == 1 ? min_second : 0x80) || c > (k == 1 ? max_second : 0xbf)) {
+            return 0;
+        }
+    }
+    return length;
+}
+
+// Valid UTF-8 is kept; other non-ASCII bytes (e.g. a Latin-1 header value)
+// are escaped as \u00XX so every line stays valid UTF-8
+static std::string jsonString(const std::string& value) {
+    std::string out = "\"";
+    for (size_t i = 0; i < value.size(); i++) {
+        unsigned char c = static_cast<unsigned char>(value[i]);
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (c >= 0x80) {
+                    size_t length = utf8SequenceLength(value, i);
+                    if (length > 0) {
+                        out.append(value, i, length);
+                        i += length - 1;
+                        break;
+                    }
+                }
+                if (c < 0x20 || c >= 0x7f) {
+                    char escaped[8];
+                    snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                    out += escaped;
+                } else {
+                    out += static_cast<char>(c);
+                }
+        }
+    }
+    return out + "\"";
+}
+
+static std::string csvField(const std::string& value) {
+    if (value.find_first_of(",\"\r\n") == std::string::npos) {
+        return value;
+    }
+    std::string out = "\"";
+    for (char c : value) {
+        out += c;
+        if (c == '"') {
+            out += '"';
+        }
+    }
+    return out + "\"";
+}
+
+// One JSON object per line
+class NDJSONSink : public ResultSink {
+public:
+    void start(const std::vector<TrackJob>& jobs) override {
+        for (const auto& job : jobs) {
+            prefixes_.push_back(",\"id\":" + jsonString(job.identifier) + ",\"url\":" + jsonString(job.url));
+        }
+    }
+
+    void write(const ResultEvent& event) override {
+        char line[1024];  // Fits every header value escaped as \u00XX
+        int length = snprintf(line, sizeof(line), "{\"ts\":%ld", static_cast<long>(time(nullptr)));
+        out_.append(line, static_cast<size_t>(length));
+        if (event.url_index < prefixes_.size()) {
+            out_.append(prefixes_[event.url_index]);
+        }
+
+        std::string ip = CIDRUtils::uint32ToIp(event.ip);
+        if (event.success) {
+            const CFHeaders& headers = event.headers;
+            length = snprintf(line, sizeof(line),
+                              ",\"ip\":\"%s\",\"status\":%u,\"cache\":%s,\"colo\":%s,\"country\":%s,"
+                              "\"ray\":%s,\"connect_ms\":%.3f,\"error\":null,\"curl_code\":0}\n",
+                              ip.c_str(), static_cast<unsigned>(event.status_code),
+                              headerValue(headers.cache_status).c_str(), headerValue(headers.iata_code).c_str(),
+                              headerValue(headers.ip_country).c_str(), headerValue(headers.ray).c_str(),
+                              event.connect_time_us / 1000.0);
+        } else {
+            length = snprintf(line, sizeof(line),
+                              ",\"ip\":\"%s\",\"status\":0,\"cache\":null,\"colo\":null,\"country\":null,"
+                              "\"ray\":null,\"connect_ms\":null,\"error\":\"%s\",\"curl_code\":%d}\n",
+                              ip.c_str(), ResultStore::errorClassName(ResultStore::classifyError(event.curl_code)),
+                              event.curl_code);
+        }
+        out_.append(line, std::min(static_cast<size_t>(length), sizeof(line) - 1));
+        count_++;
+    }
+
+private:
+    std::vector<std::string> prefixes_;  // Escaped identifier and URL per job
+
+    // Header values come from the server and are escaped; a missing one becomes null
+    static std::string headerValue(const char* value) { return value[0] ? jsonString(value) : "null"; }
+};
+
+// Header row, then one row per result
+class CSVSink : public ResultSink {
+public:
+    void start(const std::vector<TrackJob>& jobs) override {
+        for (const auto& job : jobs) {
+            prefixes_.push_back("," + csvField(job.identifier) + "," + csvField(job.url));
+        }
+        out_.append("timestamp,identifier,url,ip,status_code,cache_status,colo,country,ray,connect_ms,error,curl_code\n");
+    }
+
+    void write(const ResultEvent& event) override {
+        char line[1024];  // Fits every header value quoted with each character doubled
+        int length = snprintf(line, sizeof(line), "%ld", static_cast<long>(time(nullptr)));
+        out_.append(line, static_cast<size_t>(length));
+        if (event.url_index < prefixes_.size()) {
+            out_.append(prefixes_[event.url_index]);
+        } else {
+            out_.append(",,", 2);
+        }
+
+        std::string ip = CIDRUtils::uint32ToIp(event.ip);
+        if (event.success) {
+            const CFHeaders& headers = event.headers;
+            // Header values come from the server and may need quoting
+            length = snprintf(line, sizeof(line), ",%s,%u,%s,%s,%s,%s,%.3f,,0\n",
+                              ip.c_str(), static_cast<unsigned>(event.status_code),
+                              csvField(headers.cache_status).c_str(), csvField(headers.iata_code).c_str(),
+                              csvField(headers.ip_country).c_str(), csvField(headers.ray).c_str(),
+                              event.connect_time_us / 1000.0);
+        } else {
+            length = snprintf(line, sizeof(line), ",%s,0,,,,,,%s,%d\n",
+                              ip.c_str(), ResultStore::errorClassName(ResultStore::classifyError(event.curl_code)),
+                              event.curl_code);
+        }
+        out_.append(line, std::min(static_cast<size_t>(length), sizeof(line) - 1));
+        count_++;
+    }
+
+private:
+    std::vector<std::string> prefixes_;  // Quoted identifier and URL per job
+};
+
+// Header, URL table ("<identifier>\t<url>" entries, each a uint16_t length
+// and the bytes), then ResultRecords, all in native byte order
+class BinarySink : public ResultSink {
+public:
+    void start(const std::vector<TrackJob>& jobs) override {
+        ResultFileHeader header = {};
+        std::memcpy(header.magic, RESULTS_MAGIC, sizeof(RESULTS_MAGIC));
+        header.version = RESULTS_VERSION;
+        header.record_size = sizeof(ResultRecord);
+        header.url_count = static_cast<uint32_t>(jobs.size());
+        header.created = static_cast<uint64_t>(time(nullptr));
+        out_.append(reinterpret_cast<const char*>(&header), sizeof(header));
+
+        for (const auto& job : jobs) {
+            std::string entry = job.identifier + "\t" + job.url;
+            uint16_t length = static_cast<uint16_t>(std::min<size_t>(entry.size(), UINT16_MAX));
+            out_.append(reinterpret_cast<const char*>(&length), sizeof(length));
+            out_.append(entry.data(), length);
+        }
+    }
+
+    void write(const ResultEvent& event) override {
+        ResultRecord record = {};
+        record.ip = event.ip;
+        record.timestamp = static_cast<uint32_t>(time(nullptr));
+        record.url_index = event.url_index;
+        record.curl_code = static_cast<uint16_t>(event.curl_code);
+        if (event.success) {
+            record.ray = ResultStore::encodeRay(event.headers.ray);
+            record.connect_time_us = event.connect_time_us;
+            record.status_code = event.status_code;
+            record.iata = ResultStore::encodeIATA(event.headers.iata_code);
+            record.country = ResultStore::encodeCountry(event.headers.ip_country);
+            record.cache_status = static_cast<uint8_t>(ResultStore::parseCacheStatus(event.headers.cache_status));
+        } else {
+            record.error = static_cast<uint8_t>(ResultStore::classifyError(event.curl_code));
+        }
+        out_.append(reinterpret_cast<const char*>(&record), sizeof(record));
+        count_++;
+    }
+};
+
+ResultSink::ResultSink() : count_(0), started_(false) {
+}
+
+ResultSink::~ResultSink() {
+}
+
+void ResultSink::begin(const std::vector<TrackJob>& jobs) {
+    if (started_) {
+        return;
+    }
+    started_ = true;
+    start(jobs);
+}
+
+bool ResultSink::parseFormat(const std::string& name, Format& format) {
+    if (strcasecmp(name.c_str(), "ndjson") == 0 || strcasecmp(name.c_str(), "jsonl") == 0 ||
+        strcasecmp(name.c_str(), "json") == 0) {
+        format = Format::NDJSON;
+    } else if (strcasecmp(name.c_str(), "csv") == 0) {
+        format = Format::CSV;
+    } else if (strcasecmp(name.c_str(), "binary") == 0 || strcasecmp(name.c_str(), "bin") == 0) {
+        format = Format::BINARY;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+ResultSink::Format ResultSink::formatForPath(const std::string& path) {
+    Format format = Format::NDJSON;
+    size_t dot = path.find_last_of('.');
+    if (dot != std::string::npos && path.find('/', dot) == std::string::npos) {
+        parseFormat(path.substr(dot + 1), format);
+    }
+    return format;
+}
+
+std::unique_ptr<ResultSink> ResultSink::open(Format format, const std::string& path) {
+    std::unique_ptr<ResultSink> sink;
+    switch (format) {
+        case Format::NDJSON:
+            sink.reset(new NDJSONSink());
+            break;
+        case Format::CSV:
+            sink.reset(new CSVSink());
+            break;
+        case Format::BINARY:
+            sink.reset(new BinarySink());
+            break;
+    }
+
+    if (!sink->out_.open(path)) {
+        std::cerr << "Failed to open results output: " << path << std::endl;
+        return nullptr;
+    }
+    sink->path_ = path;
+    return sink;
+}
+
+bool ResultSink::isBinaryFile(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    char magic[sizeof(RESULTS_MAGIC)] = {};
+    file.read(magic, sizeof(magic));
+    return file && std::memcmp(magic, RESULTS_MAGIC, sizeof(RESULTS_MAGIC)) == 0;
+}
+
+bool ResultSink::readBinary(const std::string& path, std::vector<TrackJob>& jobs,
+                            std::vector<ResultRecord>& records) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "Failed to open results file: " << path << std::endl;
+        return false;
+    }
+
+    ResultFileHeader header = {};
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!file || std::memcmp(header.magic, RESULTS_MAGIC, sizeof(RESULTS_MAGIC)) != 0 ||
+        header.version != RESULTS_VERSION || header.record_size != sizeof(ResultRecord)) {
+        std::cerr << "Not a binary results file of this version: " << path << std::endl;
+        return false;
+    }
+
+    jobs.clear();
+    for (uint32_t i = 0; i < header.url_count && file; i++) {
+        uint16_t length = 0;
+        file.read(reinterpret_cast<char*>(&length), sizeof(length));
+        std::string entry(length, '\0');
+        file.read(&entry[0], length);
+
+        size_t tab = entry.find('\t');
+        TrackJob job;
+        job.identifier = entry.substr(0, tab);
+        job.url = tab == std::string::npos ? std::string() : entry.substr(tab + 1);
+        jobs.push_back(job);
+    }
+    if (!file) {
+        std::cerr << "Truncated results file: " << path << std::endl;
+        return false;
+    }
+
+    // Records run to the end of the file; a partly written last one is dropped
+    std::streampos records_start = file.tellg();
+    file.seekg(0, std::ios::end);
+    size_t count = static_cast<size_t>(file.tellg() - records_start) / sizeof(ResultRecord);
+    file.seekg(records_start);
+
+    size_t first = records.size();
+    records.resize(first + count);
+    file.read(reinterpret_cast<char*>(records.data() + first),
+              static_cast<std::streamsize>(count * sizeof(ResultRecord)));
+    if (!file) {
+        std::cerr << "Failed to read results file: " << path << std::endl;
+        records.resize(first);
+        return false;
+    }
+    return true;
+}
+
+bool ResultSink::writeBinary(const std::string& path, const std::vector<TrackJob>& jobs,
+                             const std::vector<ResultRecord>& records) {
+    std::unique_ptr<ResultSink> sink = open(Format::BINARY, path);
+    if (!sink) {
+        return false;
+    }
+    sink->begin(jobs);
+    sink->out_.append(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(ResultRecord));
+    sink->count_ = records.size();
+    return sink->close();
+}
+
+} // namespace cfpinner
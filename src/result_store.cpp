@@ -0,0 +1,187 @@
+#include "result_store.h"
+#include "result_pipeline.h"
+#include "cidr_utils.h"
+#include <curl/curl.h>
+#include <cctype>
+#include <cstdio>
+#include <strings.h>
+
+namespace cfpinner {
+
+static const char* const CACHE_STATUS_NAMES[] = {
+    "", "HIT", "MISS", "EXPIRED", "STALE", "BYPASS", "REVALIDATED", "UPDATING", "DYNAMIC", "UNKNOWN"
+};
+
+static const char* const ERROR_CLASS_NAMES[] = {
+    "", "Timeout", "Connection failed", "Could not resolve host", "TLS error", "Connection reset", "Error"
+};
+
+void ResultStore::reserve(size_t count) {
+    ips_.reserve(count);
+    url_indices_.reserve(count);
+    status_codes_.reserve(count);
+    cache_statuses_.reserve(count);
+    errors_.reserve(count);
+    iatas_.reserve(count);
+    countries_.reserve(count);
+    rays_.reserve(count);
+    connect_times_us_.reserve(count);
+}
+
+void ResultStore::clear() {
+    ips_.clear();
+    url_indices_.clear();
+    status_codes_.clear();
+    cache_statuses_.clear();
+    errors_.clear();
+    iatas_.clear();
+    countries_.clear();
+    rays_.clear();
+    connect_times_us_.clear();
+}
+
+void ResultStore::add(const ResultEvent& event) {
+    ips_.push_back(event.ip);
+    url_indices_.push_back(event.url_index);
+    status_codes_.push_back(event.status_code);
+    cache_statuses_.push_back(parseCacheStatus(event.headers.cache_status));
+    errors_.push_back(event.success ? ErrorClass::NONE : classifyError(event.curl_code));
+    iatas_.push_back(encodeIATA(event.headers.iata_code));
+    countries_.push_back(encodeCountry(event.headers.ip_country));
+    rays_.push_back(encodeRay(event.headers.ray));
+    connect_times_us_.push_back(event.connect_time_us);
+}
+
+std::string ResultStore::ipString(size_t index) const {
+    return CIDRUtils::uint32ToIp(ips_[index]);
+}
+
+std::string ResultStore::rayString(size_t index) const {
+    if (rays_[index] == 0) {
+        return "";
+    }
+
+    char buffer[24];
+    snprintf(buffer, sizeof(buffer), "%016llx", static_cast<unsigned long long>(rays_[index]));
+    std::string ray = buffer;
+    if (iatas_[index] != 0) {
+        ray += "-" + decodeIATA(iatas_[index]);
+    }
+    return ray;
+}
+
+ResultStore::Counts ResultStore::count(int url_index) const {
+    // Only the error, cache status and (when filtering) URL columns are read
+    Counts counts;
+    for (size_t i = 0; i < ips_.size(); i++) {
+        if (url_index >= 0 && url_indices_[i] != url_index) {
+            continue;
+        }
+        counts.total++;
+        if (errors_[i] != ErrorClass::NONE) {
+            counts.errors++;
+        } else if (cache_statuses_[i] == CacheStatus::HIT) {
+            counts.hits++;
+        } else {
+            counts.misses++;
+        }
+    }
+    return counts;
+}
+
+CacheStatus ResultStore::parseCacheStatus(const char* value) {
+    if (value[0] == '\0') {
+        return CacheStatus::NONE;
+    }
+    for (uint8_t i = static_cast<uint8_t>(CacheStatus::HIT); i < static_cast<uint8_t>(CacheStatus::UNKNOWN); i++) {
+        if (strcasecmp(value, CACHE_STATUS_NAMES[i]) == 0) {
+            return static_cast<CacheStatus>(i);
+        }
+    }
+    return CacheStatus::UNKNOWN;
+}
+
+const char* ResultStore::cacheStatusName(CacheStatus status) {
+    return CACHE_STATUS_NAMES[static_cast<uint8_t>(status)];
+}
+
+ErrorClass ResultStore::classifyError(int curl_code) {
+    switch (curl_code) {
+        case CURLE_OPERATION_TIMEDOUT:
+            return ErrorClass::TIMEOUT;
+        case CURLE_COULDNT_CONNECT:
+            return ErrorClass::CONNECT;
+        case CURLE_COULDNT_RESOLVE_HOST:
+        case CURLE_COULDNT_RESOLVE_PROXY:
+            return ErrorClass::RESOLVE;
+        case CURLE_SSL_CONNECT_ERROR:
+        case CURLE_PEER_FAILED_VERIFICATION:
+        case CURLE_SSL_CERTPROBLEM:
+        case CURLE_SSL_CIPHER:
+            return ErrorClass::TLS;
+        case CURLE_SEND_ERROR:
+        case CURLE_RECV_ERROR:
+        case CURLE_GOT_NOTHING:
+        case CURLE_PARTIAL_FILE:
+            return ErrorClass::RESET;
+        default:
+            return ErrorClass::OTHER;
+    }
+}
+
+const char* ResultStore::errorClassName(ErrorClass error) {
+    return ERROR_CLASS_NAMES[static_cast<uint8_t>(error)];
+}
+
+uint16_t ResultStore::encodeIATA(const char* code) {
+    uint16_t index = 0;
+    for (int i = 0; i < 3; i++) {
+        if (!std::isalpha(static_cast<unsigned char>(code[i]))) {
+            return 0;
+        }
+        index = index * 26 + (std::toupper(static_cast<unsigned char>(code[i])) - 'A');
+    }
+    return code[3] == '\0' ? index + 1 : 0;
+}
+
+std::string ResultStore::decodeIATA(uint16_t code) {
+    if (code == 0) {
+        return "";
+    }
+    code--;
+    std::string iata(3, 'A');
+    iata[2] = static_cast<char>('A' + code % 26);
+    iata[1] = static_cast<char>('A' + code / 26 % 26);
+    iata[0] = static_cast<char>('A' + code / 676);
+    return iata;
+}
+
+uint16_t ResultStore::encodeCountry(const char* code) {
+    if (code[0] == '\0' || code[1] == '\0' || code[2] != '\0') {
+        return 0;
+    }
+    return static_cast<uint16_t>(static_cast<unsigned char>(code[0]) << 8 | static_cast<unsigned char>(code[1]));
+}
+
+std::string ResultStore::decodeCountry(uint16_t code) {
+    if (code == 0) {
+        return "";
+    }
+    return std::string{static_cast<char>(code >> 8), static_cast<char>(code & 0xff)};
+}
+
+uint64_t ResultStore::encodeRay(const char* ray) {
+    // Format: "8428f15b8a9c1234-SJC"
+    uint64_t id = 0;
+    int digits = 0;
+    for (; ray[digits] != '\0' && ray[digits] != '-'; digits++) {
+        int c = std::tolower(static_cast<unsigned char>(ray[digits]));
+        if (digits == 16 || !std::isxdigit(c)) {
+            return 0;
+        }
+        id = id << 4 | static_cast<uint64_t>(c <= '9' ? c - '0' : c - 'a' + 10);
+    }
+    return digits == 16 ? id : 0;
+}
+
+} // namespace cfpinner
@@ -0,0 +1,77 @@
+#include "rtt_estimator.h"
+#include <algorithm>
+
+namespace cfpinner {
+
+// p99 of a small sample window (the max for fewer than 100 samples)
+static long percentile99(std::vector<long> samples) {
+    size_t index = (samples.size() * 99 + 99) / 100 - 1;
+    std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+    return samples[index];
+}
+
+RTTEstimator::RTTEstimator(double multiplier, long floor_ms, long ceiling_ms)
+    : multiplier_(multiplier),
+      floor_ms_(floor_ms),
+      ceiling_ms_(ceiling_ms) {
+}
+
+void RTTEstimator::setCeilingMs(long ceiling_ms) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ceiling_ms_ = ceiling_ms;
+}
+
+void RTTEstimator::add(Window& window, long connect_us, long total_us) {
+    if (window.connect_us.size() < kWindowSize) {
+        window.connect_us.push_back(connect_us);
+        window.total_us.push_back(total_us);
+    } else {
+        window.connect_us[window.next] = connect_us;
+        window.total_us[window.next] = total_us;
+        window.next = (window.next + 1) % kWindowSize;
+    }
+
+    // Refresh eagerly while warming up, then every few samples
+    window.since_update++;
+    size_t count = window.connect_us.size();
+    if (count >= kMinSamples && (count < kWindowSize || window.since_update >= kMinSamples)) {
+        window.connect_p99_us = percentile99(window.connect_us);
+        window.total_p99_us = percentile99(window.total_us);
+        window.since_update = 0;
+    }
+}
+
+void RTTEstimator::record(uint32_t block, long connect_us, long total_us) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    add(blocks_[block], connect_us, total_us);
+    add(global_, connect_us, total_us);
+}
+
+long RTTEstimator::clampMs(long p99_us) const {
+    long deadline_ms = static_cast<long>(p99_us * multiplier_ / 1000.0);
+    return std::min(std::max(deadline_ms, floor_ms_), ceiling_ms_);
+}
+
+void RTTEstimator::deadlines(uint32_t block, long& connect_ms, long& total_ms) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    const Window* window = nullptr;
+    auto it = blocks_.find(block);
+    if (it != blocks_.end() && it->second.connect_us.size() >= kMinSamples) {
+        window = &it->second;
+    } else if (global_.connect_us.size() >= kMinSamples) {
+        window = &global_;
+    }
+
+    if (!window) {
+        // No data yet: only the fixed ceiling applies
+        connect_ms = ceiling_ms_;
+        total_ms = ceiling_ms_;
+        return;
+    }
+
+    connect_ms = clampMs(window->connect_p99_us);
+    total_ms = clampMs(window->total_p99_us);
+}
+
+} // namespace cfpinner
@@ -0,0 +1,177 @@
+#include "scan_checkpoint.h"
+#include "cidr_utils.h"
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
+#include <ctime>
+
+namespace cfpinner {
+
+static const char CHECKPOINT_MAGIC[8] = {'C', 'F', 'P', 'C', 'K', 'P', 'T', '1'};
+
+struct CheckpointHeader {
+    char magic[8];         // "CFPCKPT1"
+    uint32_t version;
+    uint32_t record_size;  // sizeof(AliveRecord)
+    uint64_t scan_key;
+    uint64_t bit_count;    // Addresses covered by the bitmap
+    uint64_t completed;
+    uint64_t record_count;
+    uint64_t saved;        // Unix time
+};
+static_assert(sizeof(CheckpointHeader) == 56, "CheckpointHeader is part of the file format");
+
+ScanCheckpoint::ScanCheckpoint() : bit_count_(0), key_(0), completed_(0) {
+}
+
+void ScanCheckpoint::reset(const std::vector<std::string>& ranges, uint64_t scan_key) {
+    blocks_.clear();
+    for (const auto& range : ranges) {
+        uint32_t base;
+        int prefix_len;
+        if (range.find(':') != std::string::npos || !CIDRUtils::parseCIDR(range, base, prefix_len) ||
+            prefix_len == 0) {
+            continue;
+        }
+        Block block = {};
+        block.base = base;
+        block.size = CIDRUtils::getHostCount(prefix_len);
+        blocks_.push_back(block);
+    }
+    std::sort(blocks_.begin(), blocks_.end(), [](const Block& a, const Block& b) { return a.base < b.base; });
+
+    bit_count_ = 0;
+    for (auto& block : blocks_) {
+        block.first_bit = bit_count_;
+        bit_count_ += block.size;
+    }
+
+    bits_.assign(static_cast<size_t>((bit_count_ + 63) / 64), 0);
+    key_ = scan_key;
+    completed_ = 0;
+    records_.clear();
+}
+
+bool ScanCheckpoint::bitOf(uint32_t ip, uint64_t& bit) const {
+    // Last block starting at or before ip
+    auto it = std::upper_bound(blocks_.begin(), blocks_.end(), ip,
+                               [](uint32_t value, const Block& block) { return value < block.base; });
+    if (it == blocks_.begin()) {
+        return false;
+    }
+    const Block& block = *(it - 1);
+    if (ip - block.base >= block.size) {
+        return false;
+    }
+    bit = block.first_bit + (ip - block.base);
+    return true;
+}
+
+void ScanCheckpoint::markDone(uint32_t ip) {
+    uint64_t bit;
+    if (!bitOf(ip, bit)) {
+        return;
+    }
+    uint64_t& word = bits_[bit / 64];
+    uint64_t mask = 1ULL << (bit % 64);
+    if (!(word & mask)) {
+        word |= mask;
+        completed_++;
+    }
+}
+
+bool ScanCheckpoint::isDone(uint32_t ip) const {
+    uint64_t bit;
+    return bitOf(ip, bit) && (bits_[bit / 64] & (1ULL << (bit % 64)));
+}
+
+bool ScanCheckpoint::load(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    CheckpointHeader header = {};
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!file || std::memcmp(header.magic, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC)) != 0 ||
+        header.version != VERSION ||
+        header.record_size != sizeof(AliveRecord)) {
+        std::cerr << "Ignoring invalid or incompatible checkpoint: " << path << std::endl;
+        return false;
+    }
+    if (header.scan_key != key_ || header.bit_count != bit_count_) {
+        std::cerr << "Checkpoint " << path << " was written by a scan with other ranges or settings" << std::endl;
+        return false;
+    }
+
+    std::vector<uint64_t> bits(bits_.size());
+    std::vector<AliveRecord> records(static_cast<size_t>(std::min<uint64_t>(header.record_count, bit_count_)));
+    file.read(reinterpret_cast<char*>(bits.data()), static_cast<std::streamsize>(bits.size() * sizeof(uint64_t)));
+    file.read(reinterpret_cast<char*>(records.data()),
+              static_cast<std::streamsize>(records.size() * sizeof(AliveRecord)));
+    if (!file || records.size() != header.record_count) {
+        std::cerr << "Ignoring truncated checkpoint: " << path << std::endl;
+        return false;
+    }
+
+    bits_.swap(bits);
+    records_.swap(records);
+    completed_ = 0;
+    for (uint64_t word : bits_) {
+        completed_ += static_cast<size_t>(__builtin_popcountll(word));
+    }
+    return true;
+}
+
+bool ScanCheckpoint::save(const std::string& path) const {
+    CheckpointHeader header = {};
+    std::memcpy(header.magic, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC));
+    header.version = VERSION;
+    header.record_size = sizeof(AliveRecord);
+    header.scan_key = key_;
+    header.bit_count = bit_count_;
+    header.completed = completed_;
+    header.record_count = records_.size();
+    header.saved = static_cast<uint64_t>(time(nullptr));
+
+    std::string temp_path = path + ".tmp";
+    std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        std::cerr << "Failed to write checkpoint: " << temp_path << std::endl;
+        return false;
+    }
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(bits_.data()),
+               static_cast<std::streamsize>(bits_.size() * sizeof(uint64_t)));
+    file.write(reinterpret_cast<const char*>(records_.data()),
+               static_cast<std::streamsize>(records_.size() * sizeof(AliveRecord)));
+    file.close();
+    if (!file) {
+        std::cerr << "Failed to write checkpoint: " << temp_path << std::endl;
+        std::remove(temp_path.c_str());
+        return false;
+    }
+
+    if (std::rename(temp_path.c_str(), path.c_str()) != 0) {
+        std::cerr << "Failed to replace checkpoint: " << path << std::endl;
+        std::remove(temp_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+uint64_t ScanCheckpoint::fingerprint(const std::vector<std::string>& parts) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (const auto& part : parts) {
+        // Include the terminator so {"ab", "c"} and {"a", "bc"} differ
+        for (size_t i = 0; i <= part.size(); i++) {
+            hash ^= static_cast<unsigned char>(i < part.size() ? part[i] : '\0');
+            hash *= 1099511628211ULL;
+        }
+    }
+    return hash;
+}
+
+} // namespace cfpinner
@@ -0,0 +1,163 @@
+#include "scan_metrics.h"
+#include "http_client.h"
+#include "result_store.h"
+#include <algorithm>
+#include <cmath>
+
+namespace cfpinner {
+
+LatencyHistogram::LatencyHistogram() : sum_(0), max_(0) {
+    for (auto& count : counts_) {
+        count.store(0, std::memory_order_relaxed);
+    }
+}
+
+size_t LatencyHistogram::bucketOf(uint64_t value_us) {
+    const uint64_t sub_buckets = 1ULL << SUB_BUCKET_BITS;
+    value_us = std::min<uint64_t>(value_us, (1ULL << MAX_VALUE_BITS) - 1);
+
+    // Values below two sub-bucket ranges map one to one
+    if (value_us < 2 * sub_buckets) {
+        return static_cast<size_t>(value_us);
+    }
+
+    int top_bit = 63 - __builtin_clzll(value_us);
+    int shift = top_bit - SUB_BUCKET_BITS;
+    return static_cast<size_t>((shift + 1) * sub_buckets + ((value_us >> shift) - sub_buckets));
+}
+
+uint64_t LatencyHistogram::valueOf(size_t bucket) {
+    const uint64_t sub_buckets = 1ULL << SUB_BUCKET_BITS;
+    if (bucket < 2 * sub_buckets) {
+        return bucket;
+    }
+
+    int shift = static_cast<int>(bucket / sub_buckets) - 1;
+    uint64_t lowest = ((bucket % sub_buckets) + sub_buckets) << shift;
+    return lowest + ((1ULL << shift) >> 1);
+}
+
+void LatencyHistogram::record(uint64_t value_us) {
+    counts_[bucketOf(value_us)].fetch_add(1, std::memory_order_relaxed);
+    sum_.fetch_add(value_us, std::memory_order_relaxed);
+
+    uint64_t max = max_.load(std::memory_order_relaxed);
+    while (value_us > max && !max_.compare_exchange_weak(max, value_us, std::memory_order_relaxed)) {
+    }
+}
+
+void LatencyHistogram::mergeInto(std::vector<uint64_t>& counts, uint64_t& sum, uint64_t& max) const {
+    for (size_t i = 0; i < BUCKETS; i++) {
+        counts[i] += counts_[i].load(std::memory_order_relaxed);
+    }
+    sum += sum_.load(std::memory_order_relaxed);
+    max = std::max(max, max_.load(std::memory_order_relaxed));
+}
+
+uint64_t ScanMetrics::Latency::percentile(double q) const {
+    if (count == 0) {
+        return 0;
+    }
+
+    uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(q * count)));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < counts.size(); i++) {
+        seen += counts[i];
+        if (seen >= rank) {
+            return std::min(LatencyHistogram::valueOf(i), max_us);
+        }
+    }
+    return max_us;
+}
+
+ScanMetrics::Shard::Shard() {
+    for (auto& count : by_cache_status) {
+        count.store(0, std::memory_order_relaxed);
+    }
+    for (auto& count : by_curl_code) {
+        count.store(0, std::memory_order_relaxed);
+    }
+}
+
+ScanMetrics::ScanMetrics()
+    : shards_(new Shard[SHARDS]), start_(std::chrono::steady_clock::now()) {
+}
+
+ScanMetrics::~ScanMetrics() = default;
+
+ScanMetrics::Shard& ScanMetrics::shard() {
+    // Threads take shards round-robin the first time they record
+    static std::atomic<size_t> next_shard(0);
+    thread_local size_t index = next_shard.fetch_add(1, std::memory_order_relaxed) % SHARDS;
+    return shards_[index];
+}
+
+void ScanMetrics::probesStarted(size_t count) {
+    shard().started.fetch_add(count, std::memory_order_relaxed);
+}
+
+void ScanMetrics::probeRetried() {
+    shard().retried.fetch_add(1, std::memory_order_relaxed);
+}
+
+void ScanMetrics::probeCompleted(const HTTPResponse& response) {
+    Shard& s = shard();
+    s.completed.fetch_add(1, std::memory_order_relaxed);
+
+    if (!response.success) {
+        size_t code = std::min(static_cast<size_t>(std::max(response.curl_code, 0)), CURL_CODES - 1);
+        s.by_curl_code[code].fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    s.succeeded.fetch_add(1, std::memory_order_relaxed);
+    CacheStatus status = ResultStore::parseCacheStatus(response.cf_cache_status.c_str());
+    s.by_cache_status[static_cast<size_t>(status)].fetch_add(1, std::memory_order_relaxed);
+
+    // Connect and handshake times are 0 on a reused connection
+    if (response.connect_time_us > 0) {
+        s.latency[static_cast<size_t>(LatencyPhase::CONNECT)].record(response.connect_time_us);
+        if (response.tls_time_us > response.connect_time_us) {
+            s.latency[static_cast<size_t>(LatencyPhase::TLS)].record(response.tls_time_us - response.connect_time_us);
+        }
+    }
+    if (response.ttfb_us > 0) {
+        s.latency[static_cast<size_t>(LatencyPhase::TTFB)].record(response.ttfb_us);
+    }
+    s.latency[static_cast<size_t>(LatencyPhase::TOTAL)].record(std::max(response.total_time_us, 0L));
+}
+
+ScanMetrics::Snapshot ScanMetrics::snapshot() const {
+    Snapshot snapshot;
+    snapshot.uptime_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_).count();
+    for (auto& latency : snapshot.latency) {
+        latency.counts.assign(LatencyHistogram::BUCKETS, 0);
+    }
+
+    for (size_t i = 0; i < SHARDS; i++) {
+        const Shard& s = shards_[i];
+        snapshot.started += s.started.load(std::memory_order_relaxed);
+        snapshot.completed += s.completed.load(std::memory_order_relaxed);
+        snapshot.succeeded += s.succeeded.load(std::memory_order_relaxed);
+        snapshot.retried += s.retried.load(std::memory_order_relaxed);
+        for (size_t j = 0; j < CACHE_STATUSES; j++) {
+            snapshot.by_cache_status[j] += s.by_cache_status[j].load(std::memory_order_relaxed);
+        }
+        for (size_t j = 0; j < CURL_CODES; j++) {
+            snapshot.by_curl_code[j] += s.by_curl_code[j].load(std::memory_order_relaxed);
+        }
+        for (size_t p = 0; p < static_cast<size_t>(LatencyPhase::COUNT); p++) {
+            Latency& latency = snapshot.latency[p];
+            s.latency[p].mergeInto(latency.counts, latency.sum_us, latency.max_us);
+        }
+    }
+
+    for (auto& latency : snapshot.latency) {
+        for (uint64_t count : latency.counts) {
+            latency.count += count;
+        }
+    }
+    return snapshot;
+}
+
+} // namespace cfpinner
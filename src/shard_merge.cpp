@@ -0,0 +1,103 @@
+#include "shard_merge.h"
+#include "alive_index.h"
+#include "result_sink.h"
+#include "cdn_tracker.h"
+#include "radix_sort.h"
+#include <iostream>
+#include <unordered_map>
+#include <cstring>
+
+namespace cfpinner {
+
+bool ShardMerge::mergeAlive(const std::vector<std::string>& inputs, const std::string& output, Stats& stats) {
+    std::vector<AliveRecord> records;
+    for (const auto& path : inputs) {
+        AliveIndex index;
+        bool loaded = AliveIndex::isIndexFile(path) ? index.open(path) : index.importText(path);
+        if (!loaded) {
+            std::cerr << "Failed to read alive list: " << path << std::endl;
+            return false;
+        }
+        records.insert(records.end(), index.begin(), index.end());
+        stats.files++;
+    }
+    stats.records = records.size();
+
+    // Sorted and deduplicated by the index writer
+    if (!AliveIndex::write(output, records)) {
+        return false;
+    }
+    AliveIndex merged;
+    if (!merged.open(output)) {
+        return false;
+    }
+    stats.duplicates = stats.records - merged.size();
+    return true;
+}
+
+bool ShardMerge::mergeResults(const std::vector<std::string>& inputs, const std::string& output, Stats& stats) {
+    std::vector<TrackJob> jobs;
+    std::unordered_map<std::string, uint16_t> job_index;  // "<identifier>\t<url>" -> position in jobs
+    std::vector<ResultRecord> records;
+
+    for (const auto& path : inputs) {
+        std::vector<TrackJob> file_jobs;
+        size_t first = records.size();
+        if (!ResultSink::readBinary(path, file_jobs, records)) {
+            return false;
+        }
+
+        // Shards of one scan share their URL table; anything else is appended
+        std::vector<uint16_t> remap(file_jobs.size());
+        for (size_t i = 0; i < file_jobs.size(); i++) {
+            std::string key = file_jobs[i].identifier + "\t" + file_jobs[i].url;
+            auto it = job_index.find(key);
+            if (it == job_index.end()) {
+                if (jobs.size() > UINT16_MAX) {
+                    std::cerr << "Too many distinct URLs to merge" << std::endl;
+                    return false;
+                }
+                it = job_index.emplace(key, static_cast<uint16_t>(jobs.size())).first;
+                jobs.push_back(file_jobs[i]);
+            }
+            remap[i] = it->second;
+        }
+        for (size_t i = first; i < records.size(); i++) {
+            if (records[i].url_index < remap.size()) {
+                records[i].url_index = remap[records[i].url_index];
+            }
+        }
+        stats.files++;
+    }
+    stats.records = records.size();
+
+    // Least significant key first; each sort is stable
+    radixSort(records, [](const ResultRecord& record) { return record.timestamp; });
+    radixSort(records, [](const ResultRecord& record) { return static_cast<uint32_t>(record.url_index); });
+    radixSort(records, [](const ResultRecord& record) { return record.ip; });
+
+    // Identical records (e.g. a shard passed twice) now fall in the same
+    // run of equal IP, URL and time, which holds one or a few records
+    size_t kept = 0;
+    size_t run_start = 0;
+    for (size_t i = 0; i < records.size(); i++) {
+        const ResultRecord& record = records[i];
+        if (kept == 0 || records[run_start].ip != record.ip || records[run_start].url_index != record.url_index ||
+            records[run_start].timestamp != record.timestamp) {
+            run_start = kept;
+        }
+        bool duplicate = false;
+        for (size_t j = run_start; j < kept && !duplicate; j++) {
+            duplicate = std::memcmp(&records[j], &record, sizeof(ResultRecord)) == 0;
+        }
+        if (!duplicate) {
+            records[kept++] = record;
+        }
+    }
+    stats.duplicates = records.size() - kept;
+    records.resize(kept);
+
+    return ResultSink::writeBinary(output, jobs, records);
+}
+
+} // namespace cfpinner
@@ -0,0 +1,44 @@
+#include "timer_wheel.h"
+#include <algorithm>
+
+namespace cfpinner {
+
+TimerWheel::TimerWheel(uint64_t tick_ms, size_t slots, uint64_t start_ms)
+    : tick_ms_(std::max<uint64_t>(tick_ms, 1)),
+      current_tick_(start_ms / std::max<uint64_t>(tick_ms, 1)),
+      slots_(std::max<size_t>(slots, 1)),
+      count_(0) {
+}
+
+void TimerWheel::schedule(uint32_t id, uint64_t due_ms) {
+    uint64_t due_tick = std::max(due_ms / tick_ms_, current_tick_);
+    slots_[due_tick % slots_.size()].push_back({id, due_tick});
+    count_++;
+}
+
+void TimerWheel::advance(uint64_t now_ms, std::vector<uint32_t>& expired) {
+    uint64_t now_tick = now_ms / tick_ms_;
+
+    // After a long stall one revolution covers every slot
+    uint64_t last_tick = std::min(now_tick, current_tick_ + slots_.size() - 1);
+
+    for (uint64_t tick = current_tick_; tick <= last_tick; tick++) {
+        std::vector<Timer>& slot = slots_[tick % slots_.size()];
+        for (size_t i = 0; i < slot.size();) {
+            if (slot[i].due_tick <= now_tick) {
+                expired.push_back(slot[i].id);
+                slot[i] = slot.back();
+                slot.pop_back();
+                count_--;
+            } else {
+                i++;
+            }
+        }
+    }
+
+    if (now_tick >= current_tick_) {
+        current_tick_ = now_tick + 1;
+    }
+}
+
+} // namespace cfpinner
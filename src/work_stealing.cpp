@@ -0,0 +1,84 @@
+#include "work_stealing.h"
+#include <algorithm>
+
+namespace cfpinner {
+
+WorkStealingScheduler::WorkStealingScheduler(size_t total, size_t num_workers, size_t batch_size)
+    : num_workers_(std::max<size_t>(num_workers, 1)),
+      batch_size_(std::max<size_t>(batch_size, 1)),
+      shares_(new Share[std::max<size_t>(num_workers, 1)]),
+      steals_(0) {
+    // Contiguous initial shares keep neighbouring IPs on one worker
+    size_t per_worker = total / num_workers_;
+    size_t remainder = total % num_workers_;
+    size_t start = 0;
+    for (size_t i = 0; i < num_workers_; i++) {
+        size_t size = per_worker + (i < remainder ? 1 : 0);
+        shares_[i].begin = start;
+        shares_[i].end = start + size;
+        start += size;
+    }
+}
+
+bool WorkStealingScheduler::next(size_t worker, size_t& begin, size_t& end) {
+    Share& own = shares_[worker];
+    while (true) {
+        {
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if (own.begin < own.end) {
+                begin = own.begin;
+                end = std::min(own.begin + batch_size_, own.end);
+                own.begin = end;
+                return true;
+            }
+        }
+        if (!steal(worker)) {
+            return false;
+        }
+    }
+}
+
+bool WorkStealingScheduler::steal(size_t worker) {
+    // Shares only ever shrink, so once every other share is empty
+    // no work can show up again
+    while (true) {
+        size_t victim = num_workers_;
+        size_t most = 0;
+        for (size_t offset = 1; offset < num_workers_; offset++) {
+            size_t candidate = (worker + offset) % num_workers_;
+            std::lock_guard<std::mutex> lock(shares_[candidate].mutex);
+            size_t remaining = shares_[candidate].end - shares_[candidate].begin;
+            if (remaining > most) {
+                most = remaining;
+                victim = candidate;
+            }
+        }
+        if (victim == num_workers_) {
+            return false;
+        }
+
+        // Take the back half; the victim keeps working from the front
+        size_t stolen_begin;
+        size_t stolen_end;
+        {
+            std::lock_guard<std::mutex> lock(shares_[victim].mutex);
+            Share& share = shares_[victim];
+            size_t remaining = share.end - share.begin;
+            if (remaining == 0) {
+                continue;  // Drained while we were looking; pick again
+            }
+            size_t take = (remaining + 1) / 2;
+            stolen_end = share.end;
+            stolen_begin = share.end - take;
+            share.end = stolen_begin;
+        }
+
+        std::lock_guard<std::mutex> lock(shares_[worker].mutex);
+        shares_[worker].begin = stolen_begin;
+        shares_[worker].end = stolen_end;
+        steals_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+}
+
+} // namespace cfpinner